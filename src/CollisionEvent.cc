@@ -11,6 +11,7 @@
 #include "PhysicalConstants.hh"
 #include "DeclareMacro.hh"
 #include "QS_atomics.hh"
+#include "CycleTracking.hh"
 
 #define MAX_PRODUCTION_SIZE 4
 
@@ -22,7 +23,7 @@
 //----------------------------------------------------------------------------------------------------------------------
 
 HOST_DEVICE
-void updateTrajectory( double energy, double angle, MC_Particle& particle )
+void setTrajectory( double energy, double speed, double angle, MC_Particle& particle )
 {
     particle.kinetic_energy = energy;
     double cosTheta = angle;
@@ -32,11 +33,6 @@ void updateTrajectory( double energy, double angle, MC_Particle& particle )
     double cosPhi = cos(phi);
     double sinTheta = sqrt((1.0 - (cosTheta*cosTheta)));
     particle.direction_cosine.Rotate3DVector(sinTheta, cosTheta, sinPhi, cosPhi);
-    double speed = (PhysicalConstants::_speedOfLight *
-            sqrt((1.0 - ((PhysicalConstants::_neutronRestMassEnergy *
-            PhysicalConstants::_neutronRestMassEnergy) /
-            ((energy + PhysicalConstants::_neutronRestMassEnergy) *
-            (energy + PhysicalConstants::_neutronRestMassEnergy))))));
     particle.velocity.x = speed * particle.direction_cosine.alpha;
     particle.velocity.y = speed * particle.direction_cosine.beta;
     particle.velocity.z = speed * particle.direction_cosine.gamma;
@@ -46,12 +42,28 @@ void updateTrajectory( double energy, double angle, MC_Particle& particle )
 HOST_DEVICE_END
 
 HOST_DEVICE
+void updateTrajectory( double energy, double angle, MC_Particle& particle )
+{
+    double speed = (PhysicalConstants::_speedOfLight *
+            sqrt((1.0 - ((PhysicalConstants::_neutronRestMassEnergy *
+            PhysicalConstants::_neutronRestMassEnergy) /
+            ((energy + PhysicalConstants::_neutronRestMassEnergy) *
+            (energy + PhysicalConstants::_neutronRestMassEnergy))))));
+    setTrajectory(energy, speed, angle, particle);
+}
+HOST_DEVICE_END
 
-bool CollisionEvent(MonteCarlo* monteCarlo, MC_Particle &mc_particle, unsigned int tally_index)
+HOST_DEVICE_CLASS
+template <int Features>
+HOST_DEVICE_CUDA
+bool CollisionEvent(MonteCarlo* monteCarlo, MC_Particle &mc_particle, Balance &balance)
 {
+   const bool noFission = (Features & TrackingFeature::NoFission) != 0;
+   const bool singleMaterial = (Features & TrackingFeature::SingleMaterial) != 0;
+
    const MC_Cell_State &cell = monteCarlo->domain[mc_particle.domain].cell_state[mc_particle.cell];
 
-   int globalMatIndex = cell._material;
+   int globalMatIndex = singleMaterial ? monteCarlo->_trackingMaterial : cell._material;
 
    //------------------------------------------------------------------------------------------------------------------
    //    Pick the isotope and reaction.
@@ -62,24 +74,76 @@ bool CollisionEvent(MonteCarlo* monteCarlo, MC_Particle &mc_particle, unsigned i
    int selectedIso = -1;
    int selectedUniqueNumber = -1;
    int selectedReact = -1;
-   int numIsos = (int)monteCarlo->_materialDatabase->_mat[globalMatIndex]._iso.size();
-   
-   for (int isoIndex = 0; isoIndex < numIsos && currentCrossSection >= 0; isoIndex++)
+
+   const Material &material = monteCarlo->_materialDatabase->_mat[globalMatIndex];
+   bool continuousEnergy = monteCarlo->_nuclearData->_continuousEnergy;
+   if (monteCarlo->_nuclearData->_computeCrossSections || continuousEnergy)
    {
-      int uniqueNumber = monteCarlo->_materialDatabase->_mat[globalMatIndex]._iso[isoIndex]._gid;
-      int numReacts = monteCarlo->_nuclearData->getNumberReactions(uniqueNumber);
-      for (int reactIndex = 0; reactIndex < numReacts; reactIndex++)
+      // Accumulate the reaction cross sections until the running sum
+      // exceeds currentCrossSection.
+      int unionIndex = 0;
+      if (continuousEnergy)
+         unionIndex = monteCarlo->_nuclearData->getUnionIndex(mc_particle.kinetic_energy);
+      int numIsos = (int)material._iso.size();
+      double sum = 0.0;
+      for (int isoIndex = 0; isoIndex < numIsos && selectedIso == -1; isoIndex++)
       {
-         currentCrossSection -= macroscopicCrossSection(monteCarlo, reactIndex, mc_particle.domain, mc_particle.cell,
-                   isoIndex, mc_particle.energy_group);
-         if (currentCrossSection < 0)
+         int uniqueNumber = material._iso[isoIndex]._gid;
+         int numReacts = monteCarlo->_nuclearData->getNumberReactions(uniqueNumber);
+         for (int reactIndex = 0; reactIndex < numReacts; reactIndex++)
          {
-            selectedIso = isoIndex;
-            selectedUniqueNumber = uniqueNumber;
-            selectedReact = reactIndex;
-            break;
+            if (continuousEnergy)
+               sum += pointwiseMacroscopicCrossSection(monteCarlo, reactIndex, mc_particle.domain, mc_particle.cell,
+                                                       isoIndex, unionIndex, mc_particle.kinetic_energy);
+            else
+               sum += macroscopicCrossSection(monteCarlo, reactIndex, mc_particle.domain, mc_particle.cell,
+                                              isoIndex, mc_particle.energy_group);
+            if (sum > currentCrossSection)
+            {
+               selectedIso = isoIndex;
+               selectedUniqueNumber = uniqueNumber;
+               selectedReact = reactIndex;
+               break;
+            }
          }
       }
+      // The interpolated reactions can sum to slightly less than the
+      // interpolated total.  Take the last reaction in that case.
+      if (selectedIso == -1 && continuousEnergy && numIsos > 0)
+      {
+         selectedIso = numIsos - 1;
+         selectedUniqueNumber = material._iso[selectedIso]._gid;
+         selectedReact = monteCarlo->_nuclearData->getNumberReactions(selectedUniqueNumber) - 1;
+      }
+   }
+   else
+   {
+      // Binary search the material's cumulative reaction cross sections
+      // for the first (isotope, reaction) pair whose running sum exceeds
+      // currentCrossSection.  The table is for unit number density.
+      int numEntries = material._reactionIso.size();
+      const CrossSectionReal *cdf = &material._reactionCdf[mc_particle.energy_group * numEntries];
+      double cellNumberDensity = cell._cellNumberDensity;
+      int low = 0;
+      int high = numEntries;
+      while (low < high)
+      {
+         int mid = (low + high) / 2;
+         if (cellNumberDensity * cdf[mid] > currentCrossSection)
+            high = mid;
+         else
+            low = mid + 1;
+      }
+      // Rounding the table entries can leave the last cumulative entry
+      // just below the total.  Take the last reaction in that case.
+      if (low == numEntries && numEntries > 0)
+         low = numEntries - 1;
+      if (low < numEntries)
+      {
+         selectedIso = material._reactionIso[low];
+         selectedUniqueNumber = material._iso[selectedIso]._gid;
+         selectedReact = material._reactionIndex[low];
+      }
    }
    qs_assert(selectedIso != -1);
 
@@ -88,11 +152,27 @@ bool CollisionEvent(MonteCarlo* monteCarlo, MC_Particle &mc_particle, unsigned i
    //------------------------------------------------------------------------------------------------------------------
    double energyOut[MAX_PRODUCTION_SIZE];
    double angleOut[MAX_PRODUCTION_SIZE];
+   int groupOut[MAX_PRODUCTION_SIZE];
    int nOut = 0;
    double mat_mass = monteCarlo->_materialDatabase->_mat[globalMatIndex]._mass;
+   NuclearData* nuclearData = monteCarlo->_nuclearData;
+   bool multigroup = nuclearData->_multigroupTransfer;
 
-   monteCarlo->_nuclearData->_isotopes[selectedUniqueNumber]._species[0]._reactions[selectedReact].sampleCollision(
-      mc_particle.kinetic_energy, mat_mass, &energyOut[0], &angleOut[0], nOut, &(mc_particle.random_number_seed), MAX_PRODUCTION_SIZE );
+   NuclearDataReaction& reaction = nuclearData->getReaction(selectedReact, selectedUniqueNumber);
+   if (multigroup)
+   {
+      const GroupTransfer& transfer = (reaction._reactionType == NuclearDataReaction::Fission) ?
+         nuclearData->_fissionTransfer : material._scatterTransfer;
+      reaction.sampleCollisionGroup(
+         mc_particle.energy_group, transfer, &groupOut[0], &angleOut[0], nOut, &(mc_particle.random_number_seed), MAX_PRODUCTION_SIZE );
+      for (int outIndex = 0; outIndex < nOut; outIndex++)
+         energyOut[outIndex] = nuclearData->_groupEnergy[groupOut[outIndex]];
+   }
+   else
+   {
+      reaction.sampleCollision(
+         mc_particle.kinetic_energy, mat_mass, &energyOut[0], &angleOut[0], nOut, &(mc_particle.random_number_seed), MAX_PRODUCTION_SIZE );
+   }
 
    //--------------------------------------------------------------------------------------------------------------
    //  Post-Collision Phase 1:
@@ -100,20 +180,19 @@ bool CollisionEvent(MonteCarlo* monteCarlo, MC_Particle &mc_particle, unsigned i
    //--------------------------------------------------------------------------------------------------------------
 
    // Set the reaction for this particle.
-   QS::atomicIncrement( monteCarlo->_tallies->_balanceTask[tally_index]._collision );
-   NuclearDataReaction::Enum reactionType = monteCarlo->_nuclearData->_isotopes[selectedUniqueNumber]._species[0].\
-           _reactions[selectedReact]._reactionType;
+   balance._collision++;
+   NuclearDataReaction::Enum reactionType = reaction._reactionType;
    switch (reactionType)
    {
       case NuclearDataReaction::Scatter:
-         QS::atomicIncrement( monteCarlo->_tallies->_balanceTask[tally_index]._scatter);
+         balance._scatter++;
          break;
       case NuclearDataReaction::Absorption:
-         QS::atomicIncrement( monteCarlo->_tallies->_balanceTask[tally_index]._absorb);
+         balance._absorb++;
          break;
       case NuclearDataReaction::Fission:
-         QS::atomicIncrement( monteCarlo->_tallies->_balanceTask[tally_index]._fission);
-         QS::atomicAdd( monteCarlo->_tallies->_balanceTask[tally_index]._produce, (uint64_t) nOut);
+         balance._fission++;
+         balance._produce += nOut;
          break;
       case NuclearDataReaction::Undefined:
          printf("reactionType invalid\n");
@@ -122,30 +201,57 @@ bool CollisionEvent(MonteCarlo* monteCarlo, MC_Particle &mc_particle, unsigned i
 
    if( nOut == 0 ) return false;
 
-   for (int secondaryIndex = 1; secondaryIndex < nOut; secondaryIndex++)
+   // Without fission a collision never has secondaries.
+   int lastOut = noFission ? 1 : nOut;
+   for (int secondaryIndex = 1; secondaryIndex < lastOut; secondaryIndex++)
    {
         // Newly created particles start as copies of their parent
         MC_Particle secondaryParticle = mc_particle;
         secondaryParticle.random_number_seed = rngSpawn_Random_Number_Seed(&mc_particle.random_number_seed);
         secondaryParticle.identifier = secondaryParticle.random_number_seed;
-        updateTrajectory( energyOut[secondaryIndex], angleOut[secondaryIndex], secondaryParticle );
+        if (multigroup)
+           setTrajectory( energyOut[secondaryIndex], nuclearData->_groupSpeed[groupOut[secondaryIndex]],
+                          angleOut[secondaryIndex], secondaryParticle );
+        else
+           updateTrajectory( energyOut[secondaryIndex], angleOut[secondaryIndex], secondaryParticle );
         monteCarlo->_particleVaultContainer->addExtraParticle(secondaryParticle);
    }
 
-   updateTrajectory( energyOut[0], angleOut[0], mc_particle);
+   if (multigroup)
+      setTrajectory( energyOut[0], nuclearData->_groupSpeed[groupOut[0]], angleOut[0], mc_particle);
+   else
+      updateTrajectory( energyOut[0], angleOut[0], mc_particle);
 
    // If a fission reaction produces secondary particles we also add the original
    // particle to the "extras" that we will handle later.  This avoids the 
    // possibility of a particle doing multiple fission reactions in a single
    // kernel invocation and overflowing the extra storage with secondary particles.
-   if ( nOut > 1 ) 
+   if ( !noFission && nOut > 1 )
        monteCarlo->_particleVaultContainer->addExtraParticle(mc_particle);
 
    //If we are still tracking this particle the update its energy group
-   mc_particle.energy_group = monteCarlo->_nuclearData->getEnergyGroup(mc_particle.kinetic_energy);
+   if (multigroup)
+      mc_particle.energy_group = groupOut[0];
+   else
+      mc_particle.energy_group = nuclearData->getEnergyGroup(mc_particle.kinetic_energy);
 
    return nOut == 1;
 }
 
 HOST_DEVICE_END
 
+template bool CollisionEvent<TrackingFeature::General>(MonteCarlo*, MC_Particle&, Balance&);
+template bool CollisionEvent<TrackingFeature::NoFission>(MonteCarlo*, MC_Particle&, Balance&);
+template bool CollisionEvent<TrackingFeature::SingleMaterial>(MonteCarlo*, MC_Particle&, Balance&);
+template bool CollisionEvent<TrackingFeature::NoFission | TrackingFeature::SingleMaterial>(MonteCarlo*, MC_Particle&, Balance&);
+
+HOST_DEVICE
+bool CollisionEvent(MonteCarlo* monteCarlo, MC_Particle &mc_particle, unsigned int tally_index)
+{
+   Balance balance;
+   bool keepTracking = CollisionEvent<TrackingFeature::General>(monteCarlo, mc_particle, balance);
+   monteCarlo->_tallies->TallyBalance(balance, tally_index);
+   return keepTracking;
+}
+HOST_DEVICE_END
+
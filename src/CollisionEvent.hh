@@ -5,11 +5,22 @@
 
 class MonteCarlo;
 class MC_Particle;
+class Balance;
 
 HOST_DEVICE
 bool CollisionEvent(MonteCarlo* monteCarlo, MC_Particle &mc_particle, unsigned int tally_index );
 HOST_DEVICE_END
 
+// CollisionEvent specialized on TrackingFeature bits.  Only NoFission and
+// SingleMaterial change a collision, so it is instantiated for those
+// bits only.  The collision is counted in the history's balance, which
+// the caller adds to the tallies when the history ends.
+HOST_DEVICE_CLASS
+template <int Features>
+HOST_DEVICE_CUDA
+bool CollisionEvent(MonteCarlo* monteCarlo, MC_Particle &mc_particle, Balance &balance );
+HOST_DEVICE_END
+
 
 #endif
 
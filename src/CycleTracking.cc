@@ -10,6 +10,9 @@
 #include "QS_atomics.hh"
 #include "macros.hh"
 #include "qs_assert.hh"
+#include "MC_Processor_Info.hh"
+#include "Globals.hh"
+#include <vector>
 
 HOST_DEVICE
 void CycleTrackingGuts( MonteCarlo *monteCarlo, int particle_index, ParticleVault *processingVault, ParticleVault *processedVault )
@@ -23,20 +26,75 @@ void CycleTrackingGuts( MonteCarlo *monteCarlo, int particle_index, ParticleVaul
     mc_particle.task = 0;//processed_vault;
 
     // loop over this particle until we cannot do anything more with it on this processor
-    CycleTrackingFunction( monteCarlo, mc_particle, particle_index, processingVault, processedVault );
+    switch ( monteCarlo->_trackingFeatures )
+    {
+      case 0: CycleTrackingFunction<0>( monteCarlo, mc_particle, particle_index, processingVault, processedVault ); break;
+      case 1: CycleTrackingFunction<1>( monteCarlo, mc_particle, particle_index, processingVault, processedVault ); break;
+      case 2: CycleTrackingFunction<2>( monteCarlo, mc_particle, particle_index, processingVault, processedVault ); break;
+      case 3: CycleTrackingFunction<3>( monteCarlo, mc_particle, particle_index, processingVault, processedVault ); break;
+      case 4: CycleTrackingFunction<4>( monteCarlo, mc_particle, particle_index, processingVault, processedVault ); break;
+      case 5: CycleTrackingFunction<5>( monteCarlo, mc_particle, particle_index, processingVault, processedVault ); break;
+      case 6: CycleTrackingFunction<6>( monteCarlo, mc_particle, particle_index, processingVault, processedVault ); break;
+      case 7: CycleTrackingFunction<7>( monteCarlo, mc_particle, particle_index, processingVault, processedVault ); break;
+      default: qs_assert(false); break;
+    }
 
     //Make sure this particle is marked as completed
     processingVault->invalidateParticle( particle_index );
 }
 HOST_DEVICE_END
 
-HOST_DEVICE
+// Facet crossing specialized on the AllReflective bit.  An escape is
+// counted in the history's balance.
+HOST_DEVICE_CLASS
+template <int Features>
+HOST_DEVICE_CUDA
+bool CycleTrackingFacetCrossing( MonteCarlo *monteCarlo, MC_Particle &mc_particle, int particle_index, ParticleVault* processingVault, Balance &balance )
+{
+    const bool allReflective = (Features & TrackingFeature::AllReflective) != 0;
+
+    MC_Tally_Event::Enum facet_crossing_type = MC_Facet_Crossing_Event(mc_particle, monteCarlo, particle_index, processingVault);
+
+    // A problem detected as all reflective can have no escapes.
+    qs_assert(!allReflective || facet_crossing_type != MC_Tally_Event::Facet_Crossing_Escape);
+
+    if (facet_crossing_type == MC_Tally_Event::Facet_Crossing_Transit_Exit)
+    {
+        return true;  // Transit Event
+    }
+    else if (!allReflective && facet_crossing_type == MC_Tally_Event::Facet_Crossing_Escape)
+    {
+        balance._escape++;
+        mc_particle.last_event = MC_Tally_Event::Facet_Crossing_Escape;
+        mc_particle.species = -1;
+        return false;
+    }
+    else if (facet_crossing_type == MC_Tally_Event::Facet_Crossing_Reflection)
+    {
+        MCT_Reflect_Particle(monteCarlo, mc_particle);
+        return true;
+    }
+
+    // Enters an adjacent cell in an off-processor domain.
+    //mc_particle.species = -1;
+    return false;
+}
+HOST_DEVICE_END
+
+HOST_DEVICE_CLASS
+template <int Features>
+HOST_DEVICE_CUDA
 void CycleTrackingFunction( MonteCarlo *monteCarlo, MC_Particle &mc_particle, int particle_index, ParticleVault* processingVault, ParticleVault* processedVault)
 {
     bool keepTrackingThisParticle = false;
-    unsigned int tally_index =      (particle_index) % monteCarlo->_tallies->GetNumBalanceReplications();
-    unsigned int flux_tally_index = (particle_index) % monteCarlo->_tallies->GetNumFluxReplications();
-    unsigned int cell_tally_index = (particle_index) % monteCarlo->_tallies->GetNumCellTallyReplications();
+    unsigned int tally_index =      monteCarlo->_tallies->GetBalanceReplication(particle_index);
+    unsigned int flux_tally_index = monteCarlo->_tallies->GetFluxReplication(particle_index);
+    unsigned int cell_tally_index = monteCarlo->_tallies->GetCellTallyReplication(particle_index);
+
+    // The history counts its events and holds back its flux contributions
+    // locally, and adds them to the shared tallies once it ends.
+    Balance balance;
+    ScalarFluxAccumulator fluxAccumulator(monteCarlo->_tallies, flux_tally_index);
     do
     {
         // Determine the outcome of a particle at the end of this segment such as:
@@ -48,9 +106,9 @@ void CycleTrackingFunction( MonteCarlo *monteCarlo, MC_Particle &mc_particle, in
 #ifdef EXPONENTIAL_TALLY
         monteCarlo->_tallies->TallyCellValue( exp(rngSample(&mc_particle.random_number_seed)) , mc_particle.domain, cell_tally_index, mc_particle.cell);
 #endif   
-        MC_Segment_Outcome_type::Enum segment_outcome = MC_Segment_Outcome(monteCarlo, mc_particle, flux_tally_index);
+        MC_Segment_Outcome_type::Enum segment_outcome = MC_Segment_Outcome(monteCarlo, mc_particle, flux_tally_index, &fluxAccumulator);
 
-        QS::atomicIncrement( monteCarlo->_tallies->_balanceTask[tally_index]._numSegments);
+        balance._numSegments++;
 
         mc_particle.num_segments += 1.;  /* Track the number of segments this particle has
                                             undergone this cycle on all processes. */
@@ -60,7 +118,8 @@ void CycleTrackingFunction( MonteCarlo *monteCarlo, MC_Particle &mc_particle, in
             // The particle undergoes a collision event producing:
             //   (0) Other-than-one same-species secondary particle, or
             //   (1) Exactly one same-species secondary particle.
-            if (CollisionEvent(monteCarlo, mc_particle, tally_index ) == MC_Collision_Event_Return::Continue_Tracking)
+            const int collisionFeatures = Features & (TrackingFeature::NoFission | TrackingFeature::SingleMaterial);
+            if (CollisionEvent<collisionFeatures>(monteCarlo, mc_particle, balance ) == MC_Collision_Event_Return::Continue_Tracking)
             {
                 keepTrackingThisParticle = true;
             }
@@ -74,38 +133,18 @@ void CycleTrackingFunction( MonteCarlo *monteCarlo, MC_Particle &mc_particle, in
         case MC_Segment_Outcome_type::Facet_Crossing:
             {
                 // The particle has reached a cell facet.
-                MC_Tally_Event::Enum facet_crossing_type = MC_Facet_Crossing_Event(mc_particle, monteCarlo, particle_index, processingVault);
-
-                if (facet_crossing_type == MC_Tally_Event::Facet_Crossing_Transit_Exit)
-                {
-                    keepTrackingThisParticle = true;  // Transit Event
-                }
-                else if (facet_crossing_type == MC_Tally_Event::Facet_Crossing_Escape)
-                {
-                    QS::atomicIncrement( monteCarlo->_tallies->_balanceTask[tally_index]._escape);
-                    mc_particle.last_event = MC_Tally_Event::Facet_Crossing_Escape;
-                    mc_particle.species = -1;
-                    keepTrackingThisParticle = false;
-                }
-                else if (facet_crossing_type == MC_Tally_Event::Facet_Crossing_Reflection)
-                {
-                    MCT_Reflect_Particle(monteCarlo, mc_particle);
-                    keepTrackingThisParticle = true;
-                }
-                else
-                {
-                    // Enters an adjacent cell in an off-processor domain.
-                    //mc_particle.species = -1;
-                    keepTrackingThisParticle = false;
-                }
+                keepTrackingThisParticle = CycleTrackingFacetCrossing<Features>( monteCarlo, mc_particle, particle_index, processingVault, balance );
             }
             break;
     
         case MC_Segment_Outcome_type::Census:
             {
                 // The particle has reached the end of the time step.
-                processedVault->pushParticle(mc_particle);
-                QS::atomicIncrement( monteCarlo->_tallies->_balanceTask[tally_index]._census);
+                monteCarlo->_particleVaultContainer->addCensusParticle(mc_particle, processedVault);
+                balance._census++;
+                #ifdef THREAD_TALLIES
+                monteCarlo->_tallies->_spectrum.TallyCensus(mc_particle.energy_group);
+                #endif
                 keepTrackingThisParticle = false;
                 break;
             }
@@ -116,6 +155,199 @@ void CycleTrackingFunction( MonteCarlo *monteCarlo, MC_Particle &mc_particle, in
         }
     
     } while ( keepTrackingThisParticle );
+
+    fluxAccumulator.Flush();
+    monteCarlo->_tallies->TallyBalance(balance, tally_index);
 }
 HOST_DEVICE_END
 
+
+//----------------------------------------------------------------------------------------------------------------------
+// Event-based alternative to CycleTrackingGuts.  Instead of following one
+// history at a time, every particle in the processing vault is loaded up
+// front and the segment outcome, collision, facet crossing and census events
+// are each processed as a homogeneous loop over an event queue.  Particles that
+// survive a collision or facet crossing go back into the segment queue and the
+// loop repeats until all queues drain.
+//
+// Each particle keeps its own random number stream, its index in the
+// processing vault and its own balance, so the balance tallies are identical
+// to history-based tracking.  Only the order in which particles land in the
+// processed and extra vaults changes.
+//----------------------------------------------------------------------------------------------------------------------
+template <int Features>
+static void CycleTrackingEventLoop( MonteCarlo *monteCarlo, ParticleVault *processingVault, ParticleVault *processedVault )
+{
+    int numParticles = processingVault->size();
+
+    std::vector<MC_Particle> particles(numParticles);
+    std::vector<Balance> balance(numParticles);
+    std::vector<MC_Segment_Outcome_type::Enum> outcome(numParticles);
+    std::vector<char> keepTracking(numParticles);
+
+    // Event queues hold indices into the processing vault (and into particles).
+    std::vector<int> segmentQueue(numParticles);
+    std::vector<int> collisionQueue;
+    std::vector<int> facetQueue;
+    std::vector<int> censusQueue;
+    std::vector<int> mfpQueue;
+    collisionQueue.reserve(numParticles);
+    facetQueue.reserve(numParticles);
+    censusQueue.reserve(numParticles);
+    mfpQueue.reserve(numParticles);
+
+    const int streamBlock = 64;
+
+    Tallies* tallies = monteCarlo->_tallies;
+
+    #include "mc_omp_parallel_for_schedule_static.hh"
+    for ( int particle_index = 0; particle_index < numParticles; particle_index++ )
+    {
+        MC_Load_Particle(monteCarlo, particles[particle_index], processingVault, particle_index);
+        particles[particle_index].task = 0;
+        segmentQueue[particle_index] = particle_index;
+    }
+
+    while ( !segmentQueue.empty() )
+    {
+        int numSegments = segmentQueue.size();
+
+#ifdef EXPONENTIAL_TALLY
+        #include "mc_omp_parallel_for_schedule_static.hh"
+        for ( int ii = 0; ii < numSegments; ii++ )
+        {
+            int particle_index = segmentQueue[ii];
+            MC_Particle &mc_particle = particles[particle_index];
+            unsigned int cell_tally_index = tallies->GetCellTallyReplication(particle_index);
+            tallies->TallyCellValue( exp(rngSample(&mc_particle.random_number_seed)) , mc_particle.domain, cell_tally_index, mc_particle.cell);
+        }
+#endif
+
+        // Sample the number of mean free paths to the next collision of
+        // every particle that needs one, a block of streams at a time.
+        // MC_Segment_Outcome then finds it already set.
+        mfpQueue.clear();
+        for ( int ii = 0; ii < numSegments; ii++ )
+            if ( particles[segmentQueue[ii]].num_mean_free_paths == 0.0 ) mfpQueue.push_back(segmentQueue[ii]);
+
+        int numDraws = mfpQueue.size();
+        int numDrawBlocks = (numDraws + streamBlock - 1) / streamBlock;
+        #include "mc_omp_parallel_for_schedule_static.hh"
+        for ( int block = 0; block < numDrawBlocks; block++ )
+        {
+            int first = block * streamBlock;
+            int blockSize = std::min(streamBlock, numDraws - first);
+            uint64_t seed[streamBlock];
+            double sample[streamBlock];
+            for ( int ii = 0; ii < blockSize; ii++ )
+                seed[ii] = particles[mfpQueue[first + ii]].random_number_seed;
+            rngSampleStreams(seed, sample, blockSize);
+            for ( int ii = 0; ii < blockSize; ii++ )
+            {
+                MC_Particle &mc_particle = particles[mfpQueue[first + ii]];
+                mc_particle.random_number_seed  = seed[ii];
+                mc_particle.num_mean_free_paths = -1.0*log(sample[ii]);
+            }
+        }
+
+        // Segment outcome event
+        #include "mc_omp_parallel_for_schedule_static.hh"
+        for ( int ii = 0; ii < numSegments; ii++ )
+        {
+            int particle_index = segmentQueue[ii];
+            MC_Particle &mc_particle = particles[particle_index];
+            unsigned int flux_tally_index = tallies->GetFluxReplication(particle_index);
+            outcome[particle_index] = MC_Segment_Outcome(monteCarlo, mc_particle, flux_tally_index, NULL);
+
+            balance[particle_index]._numSegments++;
+
+            mc_particle.num_segments += 1.;
+        }
+
+        // Sort the particles into the event queues.
+        collisionQueue.clear();
+        facetQueue.clear();
+        censusQueue.clear();
+        for ( int ii = 0; ii < numSegments; ii++ )
+        {
+            int particle_index = segmentQueue[ii];
+            switch (outcome[particle_index])
+            {
+              case MC_Segment_Outcome_type::Collision:      collisionQueue.push_back(particle_index); break;
+              case MC_Segment_Outcome_type::Facet_Crossing: facetQueue.push_back(particle_index);     break;
+              case MC_Segment_Outcome_type::Census:         censusQueue.push_back(particle_index);    break;
+              default: qs_assert(false); break;
+            }
+        }
+
+        // Collision event
+        const int collisionFeatures = Features & (TrackingFeature::NoFission | TrackingFeature::SingleMaterial);
+        int numCollisions = collisionQueue.size();
+        #include "mc_omp_parallel_for_schedule_static.hh"
+        for ( int ii = 0; ii < numCollisions; ii++ )
+        {
+            int particle_index = collisionQueue[ii];
+            keepTracking[particle_index] =
+                CollisionEvent<collisionFeatures>(monteCarlo, particles[particle_index], balance[particle_index]) == MC_Collision_Event_Return::Continue_Tracking;
+        }
+
+        // Facet crossing event
+        int numFacets = facetQueue.size();
+        #include "mc_omp_parallel_for_schedule_static.hh"
+        for ( int ii = 0; ii < numFacets; ii++ )
+        {
+            int particle_index = facetQueue[ii];
+            keepTracking[particle_index] =
+                CycleTrackingFacetCrossing<Features>(monteCarlo, particles[particle_index], particle_index, processingVault, balance[particle_index]);
+        }
+
+        // Census event
+        int numCensus = censusQueue.size();
+        #include "mc_omp_parallel_for_schedule_static.hh"
+        for ( int ii = 0; ii < numCensus; ii++ )
+        {
+            int particle_index = censusQueue[ii];
+            monteCarlo->_particleVaultContainer->addCensusParticle(particles[particle_index], processedVault);
+            balance[particle_index]._census++;
+            #ifdef THREAD_TALLIES
+            tallies->_spectrum.TallyCensus(particles[particle_index].energy_group);
+            #endif
+        }
+
+        // Survivors of the collision and facet events start another segment.
+        segmentQueue.clear();
+        for ( int ii = 0; ii < numCollisions; ii++ )
+            if ( keepTracking[collisionQueue[ii]] ) segmentQueue.push_back(collisionQueue[ii]);
+        for ( int ii = 0; ii < numFacets; ii++ )
+            if ( keepTracking[facetQueue[ii]] ) segmentQueue.push_back(facetQueue[ii]);
+    }
+
+    // Add the particle balances to their replications once the wave is done.
+    for ( int particle_index = 0; particle_index < numParticles; particle_index++ )
+    {
+        tallies->_balanceTask[tallies->GetBalanceReplication(particle_index)].Add(balance[particle_index]);
+    }
+
+    //Make sure all particles are marked as completed
+    #include "mc_omp_parallel_for_schedule_static.hh"
+    for ( int particle_index = 0; particle_index < numParticles; particle_index++ )
+    {
+        processingVault->invalidateParticle( particle_index );
+    }
+}
+
+void CycleTrackingEventBased( MonteCarlo *monteCarlo, ParticleVault *processingVault, ParticleVault *processedVault )
+{
+    switch ( monteCarlo->_trackingFeatures )
+    {
+      case 0: CycleTrackingEventLoop<0>( monteCarlo, processingVault, processedVault ); break;
+      case 1: CycleTrackingEventLoop<1>( monteCarlo, processingVault, processedVault ); break;
+      case 2: CycleTrackingEventLoop<2>( monteCarlo, processingVault, processedVault ); break;
+      case 3: CycleTrackingEventLoop<3>( monteCarlo, processingVault, processedVault ); break;
+      case 4: CycleTrackingEventLoop<4>( monteCarlo, processingVault, processedVault ); break;
+      case 5: CycleTrackingEventLoop<5>( monteCarlo, processingVault, processedVault ); break;
+      case 6: CycleTrackingEventLoop<6>( monteCarlo, processingVault, processedVault ); break;
+      case 7: CycleTrackingEventLoop<7>( monteCarlo, processingVault, processedVault ); break;
+      default: qs_assert(false); break;
+    }
+}
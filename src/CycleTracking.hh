@@ -1,3 +1,6 @@
+#ifndef CYCLE_TRACKING_HH
+#define CYCLE_TRACKING_HH
+
 #include "DeclareMacro.hh"
 
 // Forward Declaration
@@ -5,10 +8,34 @@ class ParticleVault;
 class MonteCarlo;
 class MC_Particle;
 
+// Problem features that let the tracking kernels drop branches that can
+// never be taken.  They are detected once in initMC and stored as bits
+// in MonteCarlo::_trackingFeatures.  CycleTrackingGuts and
+// CycleTrackingEventBased dispatch to the kernel instantiation for those
+// bits.
+struct TrackingFeature
+{
+    public:
+    enum Enum
+    {
+        General        = 0,
+        NoFission      = 1,   // no fission reaction has a nonzero cross section
+        AllReflective  = 2,   // no particle escapes across the system boundary
+        SingleMaterial = 4,   // every cell holds the same material
+        All            = 7
+    };
+};
+
 HOST_DEVICE
 void CycleTrackingGuts( MonteCarlo *monteCarlo, int particle_index, ParticleVault *processingVault, ParticleVault *processedVault );
 HOST_DEVICE_END
 
-HOST_DEVICE
+HOST_DEVICE_CLASS
+template <int Features>
+HOST_DEVICE_CUDA
 void CycleTrackingFunction( MonteCarlo *monteCarlo, MC_Particle &mc_particle, int particle_index, ParticleVault* processingVault, ParticleVault* processedVault);
 HOST_DEVICE_END
+
+void CycleTrackingEventBased( MonteCarlo *monteCarlo, ParticleVault *processingVault, ParticleVault *processedVault );
+
+#endif
@@ -2,25 +2,70 @@
 #include "MonteCarlo.hh"
 #include "ParticleVault.hh"
 #include "ParticleVaultContainer.hh"
+#include "NuclearData.hh"
 #include "utilsMpi.hh"
 #include "MC_Processor_Info.hh"
 #include "Parameters.hh"
+#include "Tallies.hh"
+#include "Globals.hh"
 #include <string>
 
 using std::string;
 
+EnergySpectrum::EnergySpectrum(string name, uint64_t size)
+: _fileName(name), _censusEnergySpectrum(size, 0)
+{}
+
+// Allocates the per-thread histograms before the first cycle.  Each
+// thread allocates, and so first touches, its own histogram.
+void EnergySpectrum::CycleInitialize()
+{
+    #ifdef THREAD_TALLIES
+    if( _fileName == "" || !_threadSpectrum.empty() ) return;
+
+    int numThreads = omp_get_max_threads();
+    _threadSpectrum.resize(numThreads);
+    #include "mc_omp_parallel_for_schedule_static.hh"
+    for( int thread = 0; thread < numThreads; thread++ )
+        _threadSpectrum[thread].assign(_censusEnergySpectrum.size(), 0);
+    #endif
+}
+
+#ifdef THREAD_TALLIES
+// On the cpu the tracking threads count census particles as they enter
+// census (TallyCensus), so the cycle's histograms only need to be added
+// up.
+void EnergySpectrum::UpdateSpectrum(MonteCarlo*)
+{
+    if( _fileName == "" ) return;
+
+    for( size_t thread = 0; thread < _threadSpectrum.size(); thread++ )
+    {
+        std::vector<uint64_t>& threadSpectrum = _threadSpectrum[thread];
+        for( size_t group = 0; group < threadSpectrum.size(); group++ )
+        {
+            _censusEnergySpectrum[group] += threadSpectrum[group];
+            threadSpectrum[group] = 0;
+        }
+    }
+}
+#else
+// Device builds count the particles left in the vaults.
 void EnergySpectrum::UpdateSpectrum(MonteCarlo* monteCarlo)
 {
     if( _fileName == "" ) return;
 
+    // Only the energy is needed, so read it straight from the vaults
+    // rather than loading whole particles.
+    NuclearData* nuclearData = monteCarlo->_nuclearData;
+
     for( uint64_t ii = 0; ii < monteCarlo->_particleVaultContainer->processingSize(); ii++)
     {
         ParticleVault* processing = monteCarlo->_particleVaultContainer->getTaskProcessingVault( ii );
         for( uint64_t jj = 0; jj < processing->size(); jj++ )
         {
-            MC_Particle mc_particle;
-            MC_Load_Particle(monteCarlo, mc_particle, processing, jj);
-            _censusEnergySpectrum[mc_particle.energy_group]++;
+            int energy_group = nuclearData->getEnergyGroup( processing->kineticEnergy(jj) );
+            _censusEnergySpectrum[energy_group]++;
         }
     }
     for( uint64_t ii = 0; ii < monteCarlo->_particleVaultContainer->processedSize(); ii++)
@@ -28,12 +73,12 @@ void EnergySpectrum::UpdateSpectrum(MonteCarlo* monteCarlo)
         ParticleVault* processed = monteCarlo->_particleVaultContainer->getTaskProcessedVault( ii );
         for( uint64_t jj = 0; jj < processed->size(); jj++ )
         {
-            MC_Particle mc_particle;
-            MC_Load_Particle(monteCarlo, mc_particle, processed, jj);
-            _censusEnergySpectrum[mc_particle.energy_group]++;
+            int energy_group = nuclearData->getEnergyGroup( processed->kineticEnergy(jj) );
+            _censusEnergySpectrum[energy_group]++;
         }
     }
 }
+#endif
 
 void EnergySpectrum::PrintSpectrum(MonteCarlo* monteCarlo)
 {
@@ -42,7 +87,9 @@ void EnergySpectrum::PrintSpectrum(MonteCarlo* monteCarlo)
     const int count = monteCarlo->_nuclearData->_energies.size();
     uint64_t *sumHist = new uint64_t[ count ]();
 
-    mpiAllreduce( _censusEnergySpectrum.data(), sumHist, count, MPI_INT64_T, MPI_SUM, monteCarlo->processor_info->comm_mc_world );
+    // The file has a line per energy bound, one more than there are
+    // groups; the last line stays zero.
+    mpiAllreduce( _censusEnergySpectrum.data(), sumHist, _censusEnergySpectrum.size(), MPI_INT64_T, MPI_SUM, monteCarlo->processor_info->comm_mc_world );
 
     if( monteCarlo->processor_info->rank == 0 )
     {
@@ -2,19 +2,30 @@
 #define ENERGYSPECTRUM_HH
 #include <string>
 #include <vector>
+#include "macros.hh"
 
 class MonteCarlo;
 
 class EnergySpectrum
 {
     public:
-        EnergySpectrum(std::string name, uint64_t size) : _fileName(name), _censusEnergySpectrum(size,0) {};
+        EnergySpectrum(std::string name, uint64_t size);
+        void CycleInitialize();
         void UpdateSpectrum(MonteCarlo* monteCarlo);
+
+        // Counts a particle entering census in the histogram of the
+        // calling thread.  Only used on the cpu, see UpdateSpectrum.
+        void TallyCensus(int energy_group)
+        {
+            if( !_threadSpectrum.empty() )
+                _threadSpectrum[omp_get_thread_num()][energy_group]++;
+        }
         void PrintSpectrum(MonteCarlo* monteCarlo);
 
     private:
         std::string _fileName;
         std::vector<uint64_t> _censusEnergySpectrum;
+        std::vector<std::vector<uint64_t> > _threadSpectrum;   // this cycle's census, per thread
 };
 
 #endif
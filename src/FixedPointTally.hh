@@ -0,0 +1,86 @@
+#ifndef FIXED_POINT_TALLY_HH
+#define FIXED_POINT_TALLY_HH
+
+#include "portability.hh"
+#include "DeclareMacro.hh"
+#include "QS_atomics.hh"
+#include <cmath>
+
+//----------------------------------------------------------------------------------------------------------------------
+//  A tally stored as a 128 bit signed fixed point number: _high holds
+//  the integer part and _low the fraction in units of 2^-64.  Each
+//  contribution is rounded to fixed point once, when it is added, and
+//  the sum of the fixed point values is exact.  The tally therefore does
+//  not depend on the order of the contributions, so it is the same for
+//  any thread count or schedule, and an atomic add is two integer
+//  fetch-adds instead of a compare-and-swap loop on a double.
+//
+//  Contributions must be smaller than 2^63 in magnitude.
+//----------------------------------------------------------------------------------------------------------------------
+
+HOST_DEVICE_CLASS
+class FixedPointTally
+{
+   public:
+
+   HOST_DEVICE_CUDA
+   FixedPointTally() : _low(0), _high(0) {}
+
+   HOST_DEVICE_CUDA
+   FixedPointTally(double value)
+   {
+      double whole = floor(value);
+      _high = (uint64_t) (int64_t) whole;
+      // value - whole is exact and lies in [0, 1).
+      _low  = (uint64_t) ((value - whole) * 18446744073709551616.0);
+   }
+
+   HOST_DEVICE_CUDA
+   operator double() const
+   {
+      return (double) (int64_t) _high + (double) _low * 5.42101086242752217e-20;
+   }
+
+   HOST_DEVICE_CUDA
+   FixedPointTally& operator+=(const FixedPointTally& bb)
+   {
+      uint64_t low = _low + bb._low;
+      _high += bb._high + (low < _low ? 1 : 0);
+      _low = low;
+      return *this;
+   }
+
+   HOST_DEVICE_CUDA
+   FixedPointTally& operator+=(double value)
+   {
+      return *this += FixedPointTally(value);
+   }
+
+   // The carry out of the low word is found from the value the fetch-add
+   // replaced, so concurrent adds each carry exactly once.
+   HOST_DEVICE_CUDA
+   void AtomicAdd(const FixedPointTally& bb)
+   {
+      uint64_t oldLow;
+      QS::atomicCaptureAdd(_low, bb._low, oldLow);
+      uint64_t high = bb._high + (oldLow + bb._low < oldLow ? 1 : 0);
+      if (high != 0) QS::atomicAdd(_high, high);
+   }
+
+   private:
+   uint64_t _low;
+   uint64_t _high;
+};
+HOST_DEVICE_END
+
+namespace QS
+{
+   HOST_DEVICE
+   static inline void atomicAdd(FixedPointTally& aa, FixedPointTally bb)
+   {
+      aa.AtomicAdd(bb);
+   }
+   HOST_DEVICE_END
+}
+
+#endif
@@ -63,6 +63,7 @@ namespace
       int                 num_points_per_facet, // input
       int                *facet_points          /* output */);
 
+#if ! defined HAVE_FACET_BLOCK
    HOST_DEVICE_CUDA
    double MCT_Nearest_Facet_3D_G_Distance_To_Segment(
       double plane_tolerance,
@@ -74,6 +75,7 @@ namespace
       const MC_Vector &coordinate,
       const DirectionCosine *direction_cosine,
       bool allow_enter);
+#endif
 
 }
 
@@ -273,6 +275,7 @@ namespace
 
 namespace
 {
+#if ! defined HAVE_FACET_BLOCK
    ///  Calculates the distance from the specified coordinates to the
    ///  input segment. This is used to track to the faces of a 3D_G
    ///  mesh.
@@ -393,6 +396,7 @@ namespace
     }
     return PhysicalConstants::_hugeDouble;
    }
+#endif
 }
 
 
@@ -541,6 +545,91 @@ namespace
 
 namespace
 {
+#if defined HAVE_FACET_BLOCK
+   ///  Vectorized version of the facet loop in MCT_Nearest_Facet_3D_G
+   ///  over a cell's MC_Facet_Block.  Within a face every facet is
+   ///  computed without branches and masked at the end: back faces
+   ///  (normal.direction <= 0), too negative distances, and
+   ///  intersections outside the triangle get _hugeDouble.  The
+   ///  arithmetic is the same as in
+   ///  MCT_Nearest_Facet_3D_G_Distance_To_Segment, so the distances are
+   ///  identical.
+   void MCT_Nearest_Facet_3D_G_Block_Distances(const MC_Facet_Block &block,
+                                               double plane_tolerance,
+                                               const MC_Vector &coordinate,
+                                               const DirectionCosine *direction_cosine,
+                                               double *distance)
+   {
+      const double boundingBox_tolerance = 1e-9;
+      const double huge = PhysicalConstants::_hugeDouble;
+      const double x = coordinate.x, y = coordinate.y, z = coordinate.z;
+      const double alpha = direction_cosine->alpha, beta = direction_cosine->beta, gamma = direction_cosine->gamma;
+
+      // Facets 4*face .. 4*face+3 split one face of the hex.  Skip whole
+      // faces the particle is not leaving through.
+      for (int first = 0; first < MC_Facet_Block::num_facets; first += MC_Facet_Block::facets_per_face)
+      {
+         const int last = first + MC_Facet_Block::facets_per_face;
+
+         bool leaving = false;
+         for (int facet_index = first; facet_index < last; facet_index++)
+            leaving |= ( block.A[facet_index] * alpha + block.B[facet_index] * beta + block.C[facet_index] * gamma > 0.0 );
+
+         if ( !leaving )
+         {
+            for (int facet_index = first; facet_index < last; facet_index++) { distance[facet_index] = huge; }
+            continue;
+         }
+
+         #pragma omp simd
+         for (int facet_index = first; facet_index < last; facet_index++)
+         {
+            double A = block.A[facet_index], B = block.B[facet_index], C = block.C[facet_index];
+
+            double facet_normal_dot_direction_cosine = (A * alpha + B * beta + C * gamma);
+            double numerator = -1.0*(A * x + B * y + C * z + block.D[facet_index]);
+            double t = numerator / facet_normal_dot_direction_cosine;
+
+            double px = x + t * alpha;
+            double py = y + t * beta;
+            double pz = z + t * gamma;
+
+            double onto_xy = block.onto_xy[facet_index];
+            double onto_zx = block.onto_zx[facet_index];
+            double onto_yz = block.onto_yz[facet_index];
+            double pu = onto_xy * px + onto_zx * pz + onto_yz * py;
+            double pv = onto_xy * py + onto_zx * px + onto_yz * pz;
+
+            double u0 = block.u0[facet_index], v0 = block.v0[facet_index];
+            double u1 = block.u1[facet_index], v1 = block.v1[facet_index];
+            double u2 = block.u2[facet_index], v2 = block.v2[facet_index];
+
+            // Bitwise & and | keep the loop free of branches.
+            double pu_lo = pu - boundingBox_tolerance, pu_hi = pu + boundingBox_tolerance;
+            double pv_lo = pv - boundingBox_tolerance, pv_hi = pv + boundingBox_tolerance;
+            bool outside_box = ( (u0 > pu_hi) & (u1 > pu_hi) & (u2 > pu_hi) ) |
+                               ( (u0 < pu_lo) & (u1 < pu_lo) & (u2 < pu_lo) ) |
+                               ( (v0 > pv_hi) & (v1 > pv_hi) & (v2 > pv_hi) ) |
+                               ( (v0 < pv_lo) & (v1 < pv_lo) & (v2 < pv_lo) );
+
+            double cross1 = (u1 - u0) * (pv - v0) - (v1 - v0) * (pu - u0);
+            double cross2 = (u2 - u1) * (pv - v1) - (v2 - v1) * (pu - u1);
+            double cross0 = (u0 - u2) * (pv - v2) - (v0 - v2) * (pu - u2);
+            double cross_tol = 1e-9 * MC_FABS(cross0 + cross1 + cross2);
+
+            bool inside = ( (cross0 > -cross_tol) & (cross1 > -cross_tol) & (cross2 > -cross_tol) ) |
+                          ( (cross0 <  cross_tol) & (cross1 <  cross_tol) & (cross2 <  cross_tol) );
+
+            bool hit = (facet_normal_dot_direction_cosine > 0.0) &
+                       !( (numerator < 0.0) & (numerator * numerator > plane_tolerance) ) &
+                       (onto_xy + onto_zx + onto_yz != 0.0) & !outside_box & inside;
+
+            distance[facet_index] = hit ? t : huge;
+         }
+      }
+   }
+#endif
+
    ///  Calculates the distance from the specified coordinates to each
    ///  of the facets of the specified cell in a three-dimensional,
    ///  unstructured, hexahedral (Type 3D_G) domain, storing the minimum
@@ -555,13 +644,20 @@ namespace
       const DirectionCosine *direction_cosine)
    {
       // int my_task_num = mc_particle == NULL ? 0 : mc_particle->task;
-      MC_Vector *facet_coords[3];
       int                    iteration = 0;
       double                 move_factor = 0.5 * PhysicalConstants::_smallDouble;
 
       // Initialize some data for the unstructured, hexahedral mesh.
       int num_facets_per_cell = domain.mesh._cellConnectivity[location.cell].num_facets;
 
+#if ! defined HAVE_FACET_BLOCK
+      MC_Vector *facet_coords[3];
+
+      // Facet planes and connectivity of the cell, looked up once per search.
+      const MC_General_Plane   *cell_plane = domain.mesh._cellGeometry[location.cell]._facet;
+      const MC_Facet_Adjacency *cell_facet = domain.mesh._cellConnectivity[location.cell]._facet;
+#endif
+
       while (true) // will break out when distance is found
       {
          // Determine the distance to each facet of the cell.
@@ -572,12 +668,19 @@ namespace
 
          MC_Distance_To_Facet distance_to_facet[24];
 
+#if defined HAVE_FACET_BLOCK
+         double facet_distance[MC_Facet_Block::num_facets];
+         MCT_Nearest_Facet_3D_G_Block_Distances(domain.mesh._facetBlock[location.cell], plane_tolerance,
+                                                coordinate, direction_cosine, facet_distance);
+         for (int facet_index = 0; facet_index < num_facets_per_cell; facet_index++)
+            distance_to_facet[facet_index].distance = facet_distance[facet_index];
+#else
          for (int facet_index = 0; facet_index < num_facets_per_cell; facet_index++)
          {
 //to-do        mcco->distance_to_facet->task[my_task_num].facet[facet_index].distance = PhysicalConstants::_hugeDouble;
             distance_to_facet[facet_index].distance = PhysicalConstants::_hugeDouble;
 
-            MC_General_Plane &plane = domain.mesh._cellGeometry[location.cell]._facet[facet_index];
+            const MC_General_Plane &plane = cell_plane[facet_index];
 
             double facet_normal_dot_direction_cosine =
                (plane.A * direction_cosine->alpha +
@@ -591,7 +694,7 @@ namespace
 
             /* profiling with gprof showed that putting a call to MC_Facet_Coordinates_3D_G
                slowed down the code by about 10%, so we get the facet coords "by hand." */
-            int *point = domain.mesh._cellConnectivity[location.cell]._facet[facet_index].point;
+            const int *point = cell_facet[facet_index].point;
             facet_coords[0] = &domain.mesh._node[point[0]];
             facet_coords[1] = &domain.mesh._node[point[1]];
             facet_coords[2] = &domain.mesh._node[point[2]];
@@ -605,6 +708,7 @@ namespace
 //to-do        mcco->distance_to_facet->task[my_task_num].facet[facet_index].distance = t;
             distance_to_facet[facet_index].distance = t;
          } // for facet_index
+#endif
 
          int retry = 0;
 
@@ -13,9 +13,6 @@ class MC_Cell_State
 
    int _material; // gid of material
 
-   // pre-computed cross-sections for material
-   double* _total;  // [energy groups]
-
    double  _volume;                 // cell volume
    double  _cellNumberDensity;         // number density of ions in cel
 
@@ -29,7 +26,6 @@ class MC_Cell_State
 
 inline MC_Cell_State::MC_Cell_State()
   : _material(0),
-    _total(),
     _volume(0.0),
     _cellNumberDensity(0.0),
     _sourceTally(0)
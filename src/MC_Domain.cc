@@ -150,6 +150,19 @@ MC_Mesh_Domain::MC_Mesh_Domain(const MeshPartition& meshPartition, const GlobalF
             _cellGeometry[iCell]._facet[jFacet] = MC_General_Plane(r0, r1, r2);
          }
       }
+
+#ifdef HAVE_FACET_BLOCK
+      _facetBlock.resize(_cellConnectivity.size(), VAR_MEM);
+      for (unsigned iCell=0; iCell<_cellConnectivity.size(); ++iCell)
+      {
+         for (unsigned jFacet=0; jFacet<MC_Facet_Block::num_facets; ++jFacet)
+         {
+            const int* point = _cellConnectivity[iCell]._facet[jFacet].point;
+            _facetBlock[iCell].setFacet(jFacet, _cellGeometry[iCell]._facet[jFacet],
+                                        _node[point[0]], _node[point[1]], _node[point[2]]);
+         }
+      }
+#endif
    } // limit scope
    
 
@@ -357,13 +370,12 @@ double cellVolume(const MC_Facet_Adjacency_Cell& cell,
 
 MC_Domain::MC_Domain(const MeshPartition& meshPartition, const GlobalFccGrid& grid,
                      const DecompositionObject& ddc, const Parameters& params,
-                     const MaterialDatabase& materialDatabase, int numEnergyGroups)
+                     const MaterialDatabase& materialDatabase)
 : domainIndex(meshPartition.domainIndex()),
   global_domain(meshPartition.domainGid()),
   mesh(meshPartition, grid, ddc, getBoundaryCondition(params))
 {
    cell_state.resize(mesh._cellGeometry.size(), VAR_MEM);
-   _cachedCrossSectionStorage.setCapacity(cell_state.size() * numEnergyGroups, VAR_MEM);
 
    
    for (unsigned ii=0; ii<cell_state.size(); ++ii)
@@ -376,11 +388,6 @@ MC_Domain::MC_Domain(const MeshPartition& meshPartition, const GlobalFccGrid& gr
       std::string matName = findMaterial(params, point);
       cell_state[ii]._material = materialDatabase.findMaterial(matName);
 
-      cell_state[ii]._total = _cachedCrossSectionStorage.getBlock(numEnergyGroups);
-      for (unsigned jj=0; jj<numEnergyGroups; ++jj)
-         cell_state[ii]._total[jj] = 0.;
-      
-      int numIsos = static_cast<int>(materialDatabase._mat[cell_state[ii]._material]._iso.size());
       //  The cellNumberDensity scales the crossSections so we choose to
       //  set this density to 1.0 so that the totalCrossSection will be
       //  as requested by the user.
@@ -393,13 +400,6 @@ MC_Domain::MC_Domain(const MeshPartition& meshPartition, const GlobalFccGrid& gr
 
 }
 
-void MC_Domain::clearCrossSectionCache(int numEnergyGroups)
-{
-   for (unsigned ii=0; ii<cell_state.size(); ++ii)
-      for (unsigned jj=0; jj<numEnergyGroups; ++jj)
-         cell_state[ii]._total[jj] = 0.;
-}
-
 namespace
 {
    // Returns true if the specified coordinate in inside the specified
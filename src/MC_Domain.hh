@@ -34,6 +34,10 @@ class MC_Mesh_Domain
 
    qs_vector<MC_Facet_Geometry_Cell> _cellGeometry;
 
+#ifdef HAVE_FACET_BLOCK
+   qs_vector<MC_Facet_Block> _facetBlock;
+#endif
+
 
 
    BulkStorage<MC_Facet_Adjacency> _connectivityFacetStorage;
@@ -62,8 +66,6 @@ public:
 
    qs_vector<MC_Cell_State> cell_state;
 
-   BulkStorage<double> _cachedCrossSectionStorage;
-   
     // hold mesh information
     MC_Mesh_Domain mesh;
 
@@ -71,10 +73,7 @@ public:
     MC_Domain(){};
     MC_Domain(const MeshPartition& meshPartition, const GlobalFccGrid& grid,
               const DecompositionObject& ddc, const Parameters& params,
-              const MaterialDatabase& materialDatabase, int numEnergyGroups);
-
-
-   void clearCrossSectionCache(int numEnergyGroups);
+              const MaterialDatabase& materialDatabase);
 };
 
 #endif
@@ -2,6 +2,7 @@
 #define MCT_FACET_GEOMETRY_3D_INCLUDE
 
 #include "macros.hh"
+#include "MC_Vector.hh"
 #include <cstddef> // NULL
 
 // A x + B y + C z + D = 0,  (A,B,C) is the plane normal and is normalized.
@@ -48,4 +49,67 @@ class MC_Facet_Geometry_Cell
    int _size;
 };
 
+// Cpu builds with AVX or wider vectors keep a second copy of the facets
+// of each cell, stored by component, for the vectorized nearest facet
+// search in MCT.cc.  With 2-wide SSE vectors the per-facet loop and its
+// early exits are faster.
+#if defined __AVX__ && ! (defined HAVE_CUDA || defined HAVE_HIP || defined HAVE_OPENMP_TARGET)
+#define HAVE_FACET_BLOCK
+#endif
+
+// The 24 triangular facets of a cell as one structure-of-arrays block.
+// The in-triangle test projects each facet onto one coordinate plane:
+//   (u,v) = (x,y)  if |C| > 0.5
+//   (u,v) = (z,x)  else if |B| > 0.5
+//   (u,v) = (y,z)  else if |A| > 0.5
+// The triangle corners are stored projected.  The choice is stored as
+// 0/1 weights, onto_xy, onto_zx and onto_yz, so the kernel can select the
+// projected intersection point arithmetically (selects on a compare keep
+// gcc from vectorizing the loop).  A facet with no projection has all
+// weights zero and is never hit.
+class MC_Facet_Block
+{
+ public:
+   static const int num_facets = 24;
+   static const int facets_per_face = 4;
+
+   double A[num_facets];
+   double B[num_facets];
+   double C[num_facets];
+   double D[num_facets];
+
+   double u0[num_facets], v0[num_facets];
+   double u1[num_facets], v1[num_facets];
+   double u2[num_facets], v2[num_facets];
+
+   double onto_xy[num_facets];
+   double onto_zx[num_facets];
+   double onto_yz[num_facets];
+
+   void setFacet(int facet, const MC_General_Plane& plane,
+                 const MC_Vector& r0, const MC_Vector& r1, const MC_Vector& r2)
+   {
+      A[facet] = plane.A;
+      B[facet] = plane.B;
+      C[facet] = plane.C;
+      D[facet] = plane.D;
+
+      onto_xy[facet] = onto_zx[facet] = onto_yz[facet] = 0.0;
+      if      ( plane.C < -0.5 || plane.C > 0.5 ) { onto_xy[facet] = 1.0; }
+      else if ( plane.B < -0.5 || plane.B > 0.5 ) { onto_zx[facet] = 1.0; }
+      else if ( plane.A < -0.5 || plane.A > 0.5 ) { onto_yz[facet] = 1.0; }
+
+      project(facet, r0, u0[facet], v0[facet]);
+      project(facet, r1, u1[facet], v1[facet]);
+      project(facet, r2, u2[facet], v2[facet]);
+   }
+
+ private:
+   void project(int facet, const MC_Vector& r, double& u, double& v) const
+   {
+      u = onto_xy[facet] * r.x + onto_zx[facet] * r.z + onto_yz[facet] * r.y;
+      v = onto_xy[facet] * r.y + onto_zx[facet] * r.x + onto_yz[facet] * r.z;
+   }
+};
+
 #endif
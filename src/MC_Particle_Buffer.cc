@@ -1,11 +1,13 @@
 #include "MC_Particle_Buffer.hh"
 #include <time.h>
+#include <cstring>
 #include "utilsMpi.hh"
 #include "ParticleVaultContainer.hh"
 #include "SendQueue.hh"
 #include "MCT.hh"
 #include "MC_Processor_Info.hh"
 #include "MC_Base_Particle.hh"
+#include "ParticleVault.hh"
 #include "Tallies.hh"
 #include "MonteCarlo.hh"
 #include "Globals.hh"
@@ -123,6 +125,29 @@ void particle_buffer_base_type::Reset_Offsets()
     this->char_data  = p + length_int_data + length_float_data;
 }
 
+//----------------------------------------------------------------------------------------------------------------------
+//  Move the float and char data of a partially filled buffer down so the layout matches num_particles, which is
+//  what Reset_Offsets on the receiving side expects.
+//----------------------------------------------------------------------------------------------------------------------
+void particle_buffer_base_type::Compact()
+{
+    double *old_float_data = this->float_data;
+    char   *old_char_data  = this->char_data;
+
+    this->Reset_Offsets();
+
+    uint64_t length_float_data = (MC_Base_Particle::num_base_floats * num_particles) * (int)sizeof(double);
+    uint64_t length_char_data  = (MC_Base_Particle::num_base_chars  * num_particles) * (int)sizeof(char);
+
+    if ( this->float_data != old_float_data )
+    {
+        memmove(this->float_data, old_float_data, length_float_data);
+        memmove(this->char_data,  old_char_data,  length_char_data);
+    }
+
+    this->length = (char *)this->char_data + length_char_data - (char *)this->int_data;
+}
+
 //----------------------------------------------------------------------------------------------------------------------
 //  Free the memory for this particle buffer.
 //----------------------------------------------------------------------------------------------------------------------
@@ -255,7 +280,8 @@ void MC_Particle_Buffer::Initialize_Map()
 //----------------------------------------------------------------------------------------------------------------------
 //  Unpack a particle buffer that was just received.
 //----------------------------------------------------------------------------------------------------------------------
-void MC_Particle_Buffer::Unpack_Particle_Buffer(int buffer_index, uint64_t &fill_vault)
+//  If fill_vault is NULL the particles are held in deferred_particles until Add_Deferred_Particles.
+void MC_Particle_Buffer::Unpack_Particle_Buffer(int buffer_index, uint64_t *fill_vault)
 {
     MC_Base_Particle base_particle;
 
@@ -286,7 +312,10 @@ void MC_Particle_Buffer::Unpack_Particle_Buffer(int buffer_index, uint64_t &fill
 
         base_particle.last_event = MC_Tally_Event::Facet_Crossing_Communication;
 
-        mcco->_particleVaultContainer->addProcessingParticle(base_particle, fill_vault);
+        if ( fill_vault == NULL )
+            this->deferred_particles.push_back(base_particle);
+        else
+            mcco->_particleVaultContainer->addProcessingParticle(base_particle, *fill_vault);
     }
 }
 
@@ -484,6 +513,9 @@ void MC_Particle_Buffer::Send_Particle_Buffer(int buffer)
         send_buffer.int_data[0] = send_buffer.num_particles;
         send_buffer.int_data[1] = 0; //Padding
 
+        // Buffers filled by the progress thread are usually not full
+        send_buffer.Compact();
+
         if (mcco->_params.simulationParams.debugThreads >= 2)
         {
             fprintf(stderr,"%02d-%02d -> %02d %3d particles MC_Particle_Buffer::Send_Particle_Buffer\n",
@@ -525,6 +557,14 @@ void MC_Particle_Buffer::Post_Receive_Particle_Buffer( size_t bufferSize_ )
 //  Receives a particle buffer and puts the particles in it into particle vault to be processed.
 //----------------------------------------------------------------------------------------------------------------------
 void MC_Particle_Buffer::Receive_Particle_Buffers(uint64_t &fill_vault)
+{
+    this->Test_Receive_Buffers(&fill_vault);
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+//  Test all receive buffers, unpack the ones that completed and re-post their receives.
+//----------------------------------------------------------------------------------------------------------------------
+void MC_Particle_Buffer::Test_Receive_Buffers(uint64_t *fill_vault)
 {
     for ( int buffer_index = 0; buffer_index < this->num_buffers; buffer_index++ )
     {
@@ -546,6 +586,83 @@ void MC_Particle_Buffer::Receive_Particle_Buffers(uint64_t &fill_vault)
     }
 }
 
+//----------------------------------------------------------------------------------------------------------------------
+//  Allocate full size send buffers for any buffer that was handed off to MPI.  With reallocate, empty buffers that
+//  may have been sized by Allocate_Send_Buffer are replaced as well.
+//----------------------------------------------------------------------------------------------------------------------
+void MC_Particle_Buffer::Allocate_Send_Buffers(bool reallocate)
+{
+    for( int buffer = 0; buffer < this->num_buffers; buffer++ )
+    {
+        particle_buffer_base_type &send_buffer = this->task[0].send_buffer[buffer];
+        if ( reallocate && send_buffer.num_particles == 0 )
+            send_buffer.Free_Memory();
+        if ( send_buffer.int_data == NULL )
+            send_buffer.Allocate(this->buffer_size);
+    }
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+//  Called by the MPI progress thread while the other threads are tracking.  Packs every send queue entry from
+//  index packed on that has been published, and sends a buffer once it is an eighth full (or when final).
+//  Returns the index of the first entry not yet packed.
+//----------------------------------------------------------------------------------------------------------------------
+int MC_Particle_Buffer::Progress_Send_Queue(SendQueue &sendQueue, ParticleVault *processingVault, int packed, bool final)
+{
+    int capacity = sendQueue.capacity();
+    while ( packed < capacity && sendQueue.published(packed) )
+    {
+        sendQueueTuple& sendQueueT = sendQueue.getTuple( packed );
+        MC_Base_Particle mcb_particle;
+
+        processingVault->getBaseParticleComm( mcb_particle, sendQueueT._particleIndex );
+
+        int buffer = this->Choose_Buffer( sendQueueT._neighbor );
+        this->Buffer_Particle( mcb_particle, buffer );
+        packed++;
+
+        if ( this->task[0].send_buffer[buffer].num_particles == this->buffer_size )
+        {
+            this->Send_Particle_Buffer( buffer );
+            this->Allocate_Send_Buffers(false);
+        }
+    }
+
+    int send_size = ( this->buffer_size + 7 ) / 8;
+    for ( int buffer = 0; buffer < this->num_buffers; buffer++ )
+    {
+        int num_particles = this->task[0].send_buffer[buffer].num_particles;
+        if ( num_particles > 0 && ( final || num_particles >= send_size ) )
+        {
+            this->Send_Particle_Buffer( buffer );
+        }
+    }
+    this->Allocate_Send_Buffers(false);
+    this->Delete_Completed_Extra_Send_Buffers();
+
+    return packed;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+//  Receive particle buffers without touching the vaults, which may be in use by tracking threads.
+//----------------------------------------------------------------------------------------------------------------------
+void MC_Particle_Buffer::Receive_Particle_Buffers_Deferred()
+{
+    this->Test_Receive_Buffers(NULL);
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+//  Move particles received by Receive_Particle_Buffers_Deferred into the processing vaults.
+//----------------------------------------------------------------------------------------------------------------------
+void MC_Particle_Buffer::Add_Deferred_Particles(uint64_t &fill_vault)
+{
+    for ( size_t ii = 0; ii < this->deferred_particles.size(); ii++ )
+    {
+        mcco->_particleVaultContainer->addProcessingParticle(this->deferred_particles[ii], fill_vault);
+    }
+    this->deferred_particles.clear();
+}
+
 //----------------------------------------------------------------------------------------------------------------------
 //  Cancels all pending irecv requests
 //----------------------------------------------------------------------------------------------------------------------
@@ -6,12 +6,14 @@
 #include "utilsMpi.hh"
 #include <map>
 #include <list>
+#include <vector>
 
 
 // forward declarations
 class MC_Particle;
 class MonteCarlo;
 class SendQueue;
+class ParticleVault;
 
 //
 //  Type Definitions
@@ -49,6 +51,7 @@ struct particle_buffer_base_type
     void Allocate(int buffer_size);
     void Initialize_Buffer();
     void Reset_Offsets();
+    void Compact();
     void Free_Memory();
 };
 
@@ -107,10 +110,12 @@ class MC_Particle_Buffer
     mcp_test_done_class          test_done;
     particle_buffer_task_class  *task;                 // buffers for each task
     std::map<int, int>    processor_buffer_map; // Map processors to buffers. buffer_index = processor_buffer_map[processor]
+    std::vector<MC_Base_Particle> deferred_particles; // received while the vaults were being tracked
 
     void Instantiate();
     void Initialize_Map();
-    void Unpack_Particle_Buffer(int buffer_index, uint64_t &fill_vault);
+    void Unpack_Particle_Buffer(int buffer_index, uint64_t *fill_vault);
+    void Test_Receive_Buffers(uint64_t *fill_vault);
     bool Trivially_Done();
     void Delete_Completed_Extra_Send_Buffers();
 
@@ -134,6 +139,12 @@ class MC_Particle_Buffer
     void Send_Particle_Buffer(int buffer);
     void Post_Receive_Particle_Buffer(size_t batchSize_ );
     void Receive_Particle_Buffers(uint64_t &fill_vault);
+
+    // MPI progress thread support: drive communication while other threads track.
+    void Allocate_Send_Buffers(bool reallocate);
+    int  Progress_Send_Queue(SendQueue &sendQueue, ParticleVault *processingVault, int packed, bool final);
+    void Receive_Particle_Buffers_Deferred();
+    void Add_Deferred_Particles(uint64_t &fill_vault);
     void Cancel_Receive_Buffer_Requests();
 
     bool Test_Done_New( MC_New_Test_Done_Method::Enum test_done_method = MC_New_Test_Done_Method::Blocking);
@@ -5,11 +5,66 @@
 #include "DeclareMacro.hh"
 
 //----------------------------------------------------------------------------------------------------------------------
-//  A random number generator that implements a 64 bit linear congruential generator (lcg).
+//  Every particle carries one 64 bit word of random number state.  The
+//  generator that turns that word into numbers is chosen at compile time:
 //
-//  This implementation is based on the rng class from Nick Gentile.
+//  Lcg64Rng    A 64 bit linear congruential generator (lcg).  The state
+//              is the generator state and is also the output.  This
+//              implementation is based on the rng class from Nick Gentile.
+//
+//  PhiloxRng   The counter-based Philox2x32-10 generator.  The state is
+//              a counter: it starts at the stream's seed (the particle
+//              identifier) and is incremented by one per draw.  The
+//              output is the counter encrypted with a fixed key, so
+//              the n-th number of a stream is a pure function of the
+//              seed and n.  Define PHILOX_RNG to select it.
+//
+//  A draw only reads and writes the state of its own stream, so one
+//  number of each of many streams can be generated in one vectorizable
+//  loop.
 //----------------------------------------------------------------------------------------------------------------------
 
+struct Lcg64Rng
+{
+   HOST_DEVICE_CUDA
+   static uint64_t advance(uint64_t state)
+   {
+      return 2862933555777941757ULL*state + 3037000493ULL;
+   }
+
+   HOST_DEVICE_CUDA
+   static uint64_t output(uint64_t state) { return state; }
+};
+
+struct PhiloxRng
+{
+   HOST_DEVICE_CUDA
+   static uint64_t advance(uint64_t state) { return state + 1; }
+
+   // Ten Philox rounds on the two 32 bit halves of the counter.
+   HOST_DEVICE_CUDA
+   static uint64_t output(uint64_t counter)
+   {
+      uint32_t c0  = static_cast<uint32_t>( counter );
+      uint32_t c1  = static_cast<uint32_t>( counter >> 32 );
+      uint32_t key = 0x5eed1029U;
+      for (int round = 0; round < 10; round++)
+      {
+         uint64_t product = 0xD256D345ULL*c0;
+         c0  = static_cast<uint32_t>( product >> 32 ) ^ key ^ c1;
+         c1  = static_cast<uint32_t>( product );
+         key += 0x9E3779B9U;
+      }
+      return (static_cast<uint64_t>( c1 ) << 32) | c0;
+   }
+};
+
+#ifdef PHILOX_RNG
+typedef PhiloxRng QS_Rng;
+#else
+typedef Lcg64Rng QS_Rng;
+#endif
+
 // Generate a new random number seed
 HOST_DEVICE
 uint64_t rngSpawn_Random_Number_Seed(uint64_t *parent_seed);
@@ -23,12 +78,28 @@ HOST_DEVICE
 inline double rngSample(uint64_t *seed)
 {
    // Reset the state from the previous value.
-   *seed = 2862933555777941757ULL*(*seed) + 3037000493ULL;
+   *seed = QS_Rng::advance(*seed);
 
-   // Map the int state in (0,2**64) to double (0,1)
+   // Map the int output in (0,2**64) to double (0,1)
    // by multiplying by
    // 1/(2**64 - 1) = 1/18446744073709551615.
-   return 5.4210108624275222e-20*(*seed);
+   return 5.4210108624275222e-20*QS_Rng::output(*seed);
+}
+HOST_DEVICE_END
+
+// Draw the next number of each of numStreams independent streams.  The
+// streams do not depend on each other, so the loop vectorizes.  The
+// event-based tracking loop draws the mean free paths of its particles
+// with it.
+HOST_DEVICE
+inline void rngSampleStreams(uint64_t *seeds, double *samples, int numStreams)
+{
+   #pragma omp simd
+   for (int ii = 0; ii < numStreams; ii++)
+   {
+      seeds[ii] = QS_Rng::advance(seeds[ii]);
+      samples[ii] = 5.4210108624275222e-20*QS_Rng::output(seeds[ii]);
+   }
 }
 HOST_DEVICE_END
 
@@ -10,6 +10,7 @@
 #include "utils.hh"
 #include "macros.hh"
 #include "MacroscopicCrossSection.hh"
+#include "NuclearData.hh"
 #include "MCT.hh"
 #include "PhysicalConstants.hh"
 #include "DeclareMacro.hh"
@@ -28,7 +29,8 @@ HOST_DEVICE_END
 //--------------------------------------------------------------------------------------------------
 
 HOST_DEVICE 
-MC_Segment_Outcome_type::Enum MC_Segment_Outcome(MonteCarlo* monteCarlo, MC_Particle &mc_particle, unsigned int &flux_tally_index)
+MC_Segment_Outcome_type::Enum MC_Segment_Outcome(MonteCarlo* monteCarlo, MC_Particle &mc_particle, unsigned int &flux_tally_index,
+                                                 ScalarFluxAccumulator* fluxAccumulator)
 {
     // initialize distances to large number
     int number_of_events = 3;
@@ -60,7 +62,12 @@ MC_Segment_Outcome_type::Enum MC_Segment_Outcome(MonteCarlo* monteCarlo, MC_Part
 
     // Randomly determine the distance to the next collision
     // based upon the composition of the current cell.
-    double macroscopic_total_cross_section = weightedMacroscopicCrossSection(monteCarlo, 0,
+    double macroscopic_total_cross_section;
+    if (monteCarlo->_nuclearData->_continuousEnergy)
+        macroscopic_total_cross_section = weightedPointwiseMacroscopicCrossSection(monteCarlo,
+                             mc_particle.domain, mc_particle.cell, mc_particle.kinetic_energy);
+    else
+        macroscopic_total_cross_section = weightedMacroscopicCrossSection(monteCarlo, 0,
                              mc_particle.domain, mc_particle.cell, mc_particle.energy_group);
 
     // Cache the cross section
@@ -218,8 +225,12 @@ MC_Segment_Outcome_type::Enum MC_Segment_Outcome(MonteCarlo* monteCarlo, MC_Part
     }
 
     // Accumulate the particle's contribution to the scalar flux.
-    monteCarlo->_tallies->TallyScalarFlux(mc_particle.segment_path_length * mc_particle.weight, mc_particle.domain,
-                                    flux_tally_index, mc_particle.cell, mc_particle.energy_group);
+    if (fluxAccumulator != NULL)
+        fluxAccumulator->Tally(mc_particle.segment_path_length * mc_particle.weight, mc_particle.domain,
+                               mc_particle.cell, mc_particle.energy_group);
+    else
+        monteCarlo->_tallies->TallyScalarFlux(mc_particle.segment_path_length * mc_particle.weight, mc_particle.domain,
+                                        flux_tally_index, mc_particle.cell, mc_particle.energy_group);
 
     return segment_outcome;
 }
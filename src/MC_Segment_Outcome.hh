@@ -4,6 +4,7 @@
 class MC_Particle;
 class MC_Vector;
 class MonteCarlo;
+class ScalarFluxAccumulator;
 
 
 struct MC_Segment_Outcome_type
@@ -33,7 +34,8 @@ struct MC_Collision_Event_Return
 
 #include "DeclareMacro.hh"
 HOST_DEVICE
-MC_Segment_Outcome_type::Enum MC_Segment_Outcome(MonteCarlo* monteCarlo, MC_Particle &mc_particle, unsigned int &flux_tally_index);
+MC_Segment_Outcome_type::Enum MC_Segment_Outcome(MonteCarlo* monteCarlo, MC_Particle &mc_particle, unsigned int &flux_tally_index,
+                                                 ScalarFluxAccumulator* fluxAccumulator);
 HOST_DEVICE_END
 
 #endif
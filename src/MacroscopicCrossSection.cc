@@ -59,23 +59,65 @@ HOST_DEVICE
 double weightedMacroscopicCrossSection(MonteCarlo* monteCarlo, int taskIndex, int domainIndex,
                                        int cellIndex, int energyGroup)
 {
-   double* precomputedCrossSection =
-      &monteCarlo->domain[domainIndex].cell_state[cellIndex]._total[energyGroup];
-   qs_assert (precomputedCrossSection != NULL);
-   if (*precomputedCrossSection > 0.0)
-      return *precomputedCrossSection;
-   
+   const MC_Cell_State& cell = monteCarlo->domain[domainIndex].cell_state[cellIndex];
+   if (monteCarlo->_nuclearData->_computeCrossSections)
+   {
+      int nIsotopes = (int)monteCarlo->_materialDatabase->_mat[cell._material]._iso.size();
+      double sum = 0.0;
+      for (int isoIndex = 0; isoIndex < nIsotopes; isoIndex++)
+      {
+         sum += macroscopicCrossSection(monteCarlo, -1, domainIndex, cellIndex,
+                                        isoIndex, energyGroup);
+      }
+      return sum;
+   }
+
+   // The material table is for unit cell number density.
+   return cell._cellNumberDensity *
+          monteCarlo->_materialDatabase->_mat[cell._material]._totalCrossSection[energyGroup];
+}
+HOST_DEVICE_END
+
+
+//----------------------------------------------------------------------------------------------------------------------
+//  Routine pointwiseMacroscopicCrossSection is macroscopicCrossSection for the continuous-energy
+//  data.  unionIndex is NuclearData::getUnionIndex(energy).
+//
+//  A reactionIndex of -1 means total cross section.
+//----------------------------------------------------------------------------------------------------------------------
+HOST_DEVICE
+double pointwiseMacroscopicCrossSection(MonteCarlo* monteCarlo, int reactionIndex, int domainIndex, int cellIndex,
+                                        int isoIndex, int unionIndex, double energy)
+{
+   const MC_Cell_State& cell = monteCarlo->domain[domainIndex].cell_state[cellIndex];
+   const Isotope& isotope = monteCarlo->_materialDatabase->_mat[cell._material]._iso[isoIndex];
+   if ( isotope._atomFraction == 0.0 || cell._cellNumberDensity == 0.0) { return 1e-20; }
+
+   double microscopicCrossSection =
+      monteCarlo->_nuclearData->getPointwiseCrossSection(reactionIndex, isotope._gid, unionIndex, energy);
+
+   return isotope._atomFraction * cell._cellNumberDensity * microscopicCrossSection;
+}
+HOST_DEVICE_END
+
+
+//----------------------------------------------------------------------------------------------------------------------
+//  Routine weightedPointwiseMacroscopicCrossSection calculates the total macroscopic cross
+//  section of a cell at this energy from the continuous-energy data.
+//----------------------------------------------------------------------------------------------------------------------
+HOST_DEVICE
+double weightedPointwiseMacroscopicCrossSection(MonteCarlo* monteCarlo, int domainIndex,
+                                                int cellIndex, double energy)
+{
    int globalMatIndex = monteCarlo->domain[domainIndex].cell_state[cellIndex]._material;
    int nIsotopes = (int)monteCarlo->_materialDatabase->_mat[globalMatIndex]._iso.size();
+   int unionIndex = monteCarlo->_nuclearData->getUnionIndex(energy);
    double sum = 0.0;
    for (int isoIndex = 0; isoIndex < nIsotopes; isoIndex++)
    {
-      sum += macroscopicCrossSection(monteCarlo, -1, domainIndex, cellIndex,
-                                     isoIndex, energyGroup);
+      sum += pointwiseMacroscopicCrossSection(monteCarlo, -1, domainIndex, cellIndex,
+                                              isoIndex, unionIndex, energy);
    }
-
-   QS::atomicWrite( *precomputedCrossSection, sum );
-
    return sum;
 }
 HOST_DEVICE_END
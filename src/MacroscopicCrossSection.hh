@@ -15,4 +15,14 @@ double weightedMacroscopicCrossSection(MonteCarlo* monteCarlo, int taskIndex, in
                                        int cellIndex, int energyGroup);
 HOST_DEVICE_END
 
+HOST_DEVICE
+double pointwiseMacroscopicCrossSection(MonteCarlo* monteCarlo, int reactionIndex, int domainIndex, int cellIndex,
+                                        int isoIndex, int unionIndex, double energy);
+HOST_DEVICE_END
+
+HOST_DEVICE
+double weightedPointwiseMacroscopicCrossSection(MonteCarlo* monteCarlo, int domainIndex,
+                                                int cellIndex, double energy);
+HOST_DEVICE_END
+
 #endif
@@ -6,6 +6,7 @@
 #include <cstdlib>
 #include <cmath>
 #include "qs_assert.hh"
+#include "NuclearData.hh"
 
 // For this material, store the global id in NuclearData of the isotope
 class Isotope
@@ -32,6 +33,24 @@ class Material
    double _mass;
    qs_vector<Isotope> _iso;
 
+   // Total macroscopic cross section at unit cell number density,
+   // indexed by energy group.  Every cell of the material shares it.
+   qs_vector<CrossSectionReal> _totalCrossSection;
+
+   // Cumulative macroscopic reaction cross sections at unit cell number
+   // density, used to select the isotope and reaction of a collision.
+   // Entry ii of group gg is _reactionCdf[gg*_reactionIso.size() + ii]
+   // and is the sum over every (isotope, reaction) pair up to and
+   // including (_reactionIso[ii], _reactionIndex[ii]), in the order
+   // the isotopes and their reactions are stored.
+   qs_vector<CrossSectionReal> _reactionCdf;
+   qs_vector<int>    _reactionIso;
+   qs_vector<int>    _reactionIndex;
+
+   // Outgoing group probabilities of scattering in this material, used
+   // when NuclearData::_multigroupTransfer is set.
+   GroupTransfer _scatterTransfer;
+
    Material()
    : _name("0"), _mass(1000.0) {}
 
@@ -110,4 +129,4 @@ class MaterialDatabase
 // table NAME2
 //
 // Each isotope inside a material will have identical cross sections.
-// However, it will be treated as unique in the nuclear data.
+// It keeps its own gid, but its data is only stored once.
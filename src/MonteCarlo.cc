@@ -8,6 +8,7 @@
 #include "MC_Time_Info.hh"
 #include "MC_Particle_Buffer.hh"
 #include "MC_Fast_Timer.hh"
+#include "ParticleScheduler.hh"
 #include <cmath>
 
 #include "macros.hh" // current location of openMP wrappers.
@@ -53,6 +54,8 @@ MonteCarlo::MonteCarlo(const Parameters& params)
     #endif
 
    source_particle_weight = 0.0;
+   _trackingFeatures = 0;
+   _trackingMaterial = 0;
 
     size_t num_processors = processor_info->num_processors;
     size_t num_particles  = params.simulationParams.nParticles;
@@ -107,6 +110,11 @@ MonteCarlo::MonteCarlo(const Parameters& params)
         _particleVaultContainer = new ParticleVaultContainer(batch_size, num_batches, num_extra_vaults);
     #endif
 
+    // The scheduler only runs on the host, so it never needs managed memory.
+    particle_scheduler = NULL;
+    if ( params.simulationParams.workStealing != 0 )
+        particle_scheduler = new ParticleScheduler( params.simulationParams.workStealing == 1 );
+
 }
 
 //----------------------------------------------------------------------------------------------------------------------
@@ -144,12 +152,6 @@ MonteCarlo::~MonteCarlo()
         delete fast_timer;
         delete particle_buffer;
     #endif
-}
 
-void MonteCarlo::clearCrossSectionCache()
-{
-   int numEnergyGroups = _nuclearData->_numEnergyGroups;
-   for (unsigned ii=0; ii<domain.size(); ++ii)
-      domain[ii].clearCrossSectionCache(numEnergyGroups);
+    delete particle_scheduler;
 }
-
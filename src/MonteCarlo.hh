@@ -14,6 +14,7 @@ class MC_Processor_Info;
 class MC_Time_Info;
 class MC_Particle_Buffer;
 class MC_Fast_Timer_Container;
+class ParticleScheduler;
 
 class MonteCarlo
 {
@@ -24,7 +25,6 @@ public:
 
 public:
 
-   void clearCrossSectionCache();
 
    qs_vector<MC_Domain> domain;
 
@@ -37,6 +37,9 @@ public:
     MC_Fast_Timer_Container *fast_timer;
     MC_Processor_Info *processor_info;
     MC_Particle_Buffer *particle_buffer;
+    ParticleScheduler *particle_scheduler;
+    int _trackingFeatures;         //!< TrackingFeature bits of this problem
+    int _trackingMaterial;         //!< material of every cell when SingleMaterial is set
 
     double source_particle_weight;
 
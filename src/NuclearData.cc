@@ -1,18 +1,45 @@
 #include "NuclearData.hh"
 #include <cmath>
 #include "MC_RNG_State.hh"
+#include "PhysicalConstants.hh"
 #include "DeclareMacro.hh"
 #include "qs_assert.hh"
 
 using std::log10;
 using std::pow;
 
+namespace
+{
+   // True if both isotopes have the same reactions with the same data.
+   bool sameIsotopeData(NuclearDataIsotope& aa, NuclearDataIsotope& bb)
+   {
+      qs_vector<NuclearDataReaction>& aReactions = aa._species[0]._reactions;
+      qs_vector<NuclearDataReaction>& bReactions = bb._species[0]._reactions;
+      if (aReactions.size() != bReactions.size()) return false;
+      for (int reactIndex = 0; reactIndex < aReactions.size(); reactIndex++)
+      {
+         NuclearDataReaction& aReaction = aReactions[reactIndex];
+         NuclearDataReaction& bReaction = bReactions[reactIndex];
+         if (aReaction._reactionType != bReaction._reactionType ||
+             aReaction._nuBar != bReaction._nuBar ||
+             aReaction._crossSection.size() != bReaction._crossSection.size())
+            return false;
+         for (int group = 0; group < aReaction._crossSection.size(); group++)
+            if (aReaction._crossSection[group] != bReaction._crossSection[group])
+               return false;
+      }
+      return true;
+   }
+}
+
 // Set the cross section values and reaction type
 // Cross sections are scaled to produce the supplied reactionCrossSection at 1MeV.
 NuclearDataReaction::NuclearDataReaction(
    Enum reactionType, double nuBar, const qs_vector<double>& energies,
    const Polynomial& polynomial, double reactionCrossSection)
 : _crossSection(energies.size()-1, 0., VAR_MEM),
+  _polynomial(polynomial),
+  _scale(1.0),
   _reactionType(reactionType),
   _nuBar(nuBar)
 {
@@ -36,9 +63,9 @@ NuclearDataReaction::NuclearDataReaction(
    qs_assert(normalization > 0.);
 
    // scale to specified reaction cross section
-   double scale = reactionCrossSection/normalization;
+   _scale = reactionCrossSection/normalization;
    for (int ii=0; ii<nGroups; ++ii)
-      _crossSection[ii] *= scale;
+      _crossSection[ii] *= _scale;
 }
 
 //This has problems as written for GPU code so replaced vectors with arrays
@@ -89,6 +116,217 @@ void NuclearDataReaction::sampleCollision(
 
 HOST_DEVICE_END
 
+// Sample the collision as sampleCollision does, but draw the outgoing
+// groups from the transfer table of this reaction instead of sampling
+// continuous energies.  The random number sequence is the same.
+HOST_DEVICE
+
+void NuclearDataReaction::sampleCollisionGroup(
+   int incidentGroup, const GroupTransfer& transfer, int* groupOut,
+   double* angleOut, int &nOut, uint64_t* seed, int max_production_size)
+{
+   switch(_reactionType)
+   {
+     case Scatter:
+      nOut = 1;
+      groupOut[0] = transfer.sample(incidentGroup, rngSample(seed));
+      angleOut[0] = rngSample(seed) * 2.0 - 1.0;
+      break;
+     case Absorption:
+      break;
+     case Fission:
+      {
+         int numParticleOut = (int)(_nuBar + rngSample(seed));
+         qs_assert( numParticleOut <= max_production_size );
+         nOut = numParticleOut;
+         for (int outIndex = 0; outIndex < numParticleOut; outIndex++)
+         {
+            groupOut[outIndex] = transfer.sample(0, rngSample(seed));
+            angleOut[outIndex] = rngSample(seed) * 2.0 - 1.0;
+         }
+      }
+      break;
+     case Undefined:
+      printf("_reactionType invalid\n");
+      qs_assert(false);
+   }
+}
+
+HOST_DEVICE_END
+
+// Keep the band of nonzero probabilities of each row as a cumulative
+// distribution.  The last entry of a row is set to exactly 1.
+void GroupTransfer::setRows(const std::vector<std::vector<double> >& probability)
+{
+   int numRows = probability.size();
+   std::vector<int> first(numRows), last(numRows);
+   int numEntries = 0;
+   for (int row = 0; row < numRows; row++)
+   {
+      int numGroups = probability[row].size();
+      first[row] = 0;
+      while (first[row] < numGroups-1 && probability[row][first[row]] <= 0.0)
+         first[row]++;
+      last[row] = numGroups-1;
+      while (last[row] > first[row] && probability[row][last[row]] <= 0.0)
+         last[row]--;
+      numEntries += last[row] - first[row] + 1;
+   }
+
+   _firstGroup.resize(numRows, VAR_MEM);
+   _rowOffset.resize(numRows+1, VAR_MEM);
+   _cdf.resize(numEntries, VAR_MEM);
+
+   int index = 0;
+   for (int row = 0; row < numRows; row++)
+   {
+      _firstGroup[row] = first[row];
+      _rowOffset[row] = index;
+      double sum = 0.0;
+      for (int group = first[row]; group <= last[row]; group++)
+      {
+         sum += probability[row][group];
+         _cdf[index++] = sum;
+      }
+      for (int entry = _rowOffset[row]; entry < index; entry++)
+         _cdf[entry] /= sum;
+      _cdf[index-1] = 1.0;
+   }
+   _rowOffset[numRows] = index;
+}
+
+// Scattering leaves energy E*(1 - u/mass) for a uniform u, so from the
+// midpoint of each incident group the outgoing energy is uniform over
+// [E*(1 - 1/mass), E].  The group probabilities are the overlaps of
+// that interval with the groups.  As in getEnergyGroup, energies below
+// the grid count in the first group.
+void NuclearData::buildScatterTransfer(double material_mass, GroupTransfer& transfer)
+{
+   std::vector<std::vector<double> > probability(_numEnergyGroups,
+                                                 std::vector<double>(_numEnergyGroups, 0.0));
+   for (int group = 0; group < _numEnergyGroups; group++)
+   {
+      double high = _groupEnergy[group];
+      double low = high * (1.0 - 1.0/material_mass);
+      if (low < 0.0) low = 0.0;
+      for (int outGroup = 0; outGroup <= group; outGroup++)
+      {
+         double lower = (outGroup == 0) ? low : std::max(low, _energies[outGroup]);
+         double upper = std::min(high, _energies[outGroup+1]);
+         if (high > low)
+            probability[group][outGroup] = std::max(0.0, upper - lower) / (high - low);
+      }
+      if (high <= low)
+         probability[group][group] = 1.0;
+   }
+   transfer.setRows(probability);
+}
+
+// Fission neutrons get energy 20*r*r with r uniform in [0.5,1) (see
+// sampleCollision), so P(E < e) = 2*sqrt(e/20) - 1 on [5,20].  Energies
+// above the grid count in the last group.
+void NuclearData::buildFissionTransfer()
+{
+   std::vector<std::vector<double> > probability(1, std::vector<double>(_numEnergyGroups, 0.0));
+   double previous = 0.0;
+   for (int group = 0; group < _numEnergyGroups; group++)
+   {
+      double cumulative = 1.0;
+      if (group < _numEnergyGroups-1)
+         cumulative = std::min(1.0, std::max(0.0, 2.0*sqrt(_energies[group+1]/20.0) - 1.0));
+      probability[0][group] = cumulative - previous;
+      previous = cumulative;
+   }
+   _fissionTransfer.setRows(probability);
+}
+
+// Build the continuous-energy tables from the reaction polynomials.
+// Every distinct isotope gets numPoints log-spaced energies between
+// the grid limits.  The interior points of each isotope are shifted by
+// a different fraction of the spacing so the grids differ the way
+// evaluated data does, which gives the union grid its usual size.
+void NuclearData::buildPointwiseTables(int numPoints)
+{
+   qs_assert(numPoints >= 2);
+   int numData = _isotopes.size();
+   double logLow = log(_energies[0]);
+   double logHigh = log(_energies[_numEnergyGroups]);
+   double delta = (logHigh - logLow) / (numPoints - 1);
+
+   _pointOffset.resize(numData+1, VAR_MEM);
+   _pointValueOffset.resize(numData+1, VAR_MEM);
+   int numValues = 0;
+   for (int dataIndex = 0; dataIndex < numData; dataIndex++)
+   {
+      _pointOffset[dataIndex] = dataIndex * numPoints;
+      _pointValueOffset[dataIndex] = numValues;
+      numValues += numPoints * (_isotopes[dataIndex]._species[0]._reactions.size() + 1);
+   }
+   _pointOffset[numData] = numData * numPoints;
+   _pointValueOffset[numData] = numValues;
+
+   _pointEnergy.resize(numData * numPoints, VAR_MEM);
+   _pointValue.resize(numValues, VAR_MEM);
+   for (int dataIndex = 0; dataIndex < numData; dataIndex++)
+   {
+      double shift = (double)dataIndex / numData - 0.5;
+      qs_vector<NuclearDataReaction>& reactions = _isotopes[dataIndex]._species[0]._reactions;
+      int numReacts = reactions.size();
+      for (int point = 0; point < numPoints; point++)
+      {
+         double energy = exp(logLow + (point + shift) * delta);
+         if (point == 0) energy = _energies[0];
+         if (point == numPoints-1) energy = _energies[_numEnergyGroups];
+         _pointEnergy[_pointOffset[dataIndex] + point] = energy;
+
+         CrossSectionReal* row = &_pointValue[_pointValueOffset[dataIndex] + point*(numReacts+1)];
+         double log10Energy = log10(energy);
+         double totalCrossSection = 0.0;
+         for (int reactIndex = 0; reactIndex < numReacts; reactIndex++)
+         {
+            row[reactIndex+1] = reactions[reactIndex].computeCrossSection(log10Energy);
+            totalCrossSection += row[reactIndex+1];
+         }
+         row[0] = totalCrossSection;
+      }
+   }
+
+   std::vector<double> unionEnergy(&_pointEnergy[0], &_pointEnergy[0] + numData * numPoints);
+   std::sort(unionEnergy.begin(), unionEnergy.end());
+   unionEnergy.erase(std::unique(unionEnergy.begin(), unionEnergy.end()), unionEnergy.end());
+   int numUnion = unionEnergy.size();
+   _unionEnergy.resize(numUnion, VAR_MEM);
+   for (int unionIndex = 0; unionIndex < numUnion; unionIndex++)
+      _unionEnergy[unionIndex] = unionEnergy[unionIndex];
+
+   // Point indices are clamped to numPoints-2 so the interpolation
+   // always has an upper neighbor.
+   _unionIndex.resize(numUnion * numData, VAR_MEM);
+   for (int dataIndex = 0; dataIndex < numData; dataIndex++)
+   {
+      const double* energy = &_pointEnergy[_pointOffset[dataIndex]];
+      int point = 0;
+      for (int unionIndex = 0; unionIndex < numUnion; unionIndex++)
+      {
+         while (point < numPoints-2 && energy[point+1] <= _unionEnergy[unionIndex])
+            point++;
+         _unionIndex[unionIndex*numData + dataIndex] = point;
+      }
+   }
+
+   int numBins = numPoints;
+   _hashInverseDelta = numBins / (logHigh - logLow);
+   _hashIndex.resize(numBins+1, VAR_MEM);
+   int unionIndex = 0;
+   for (int bin = 0; bin <= numBins; bin++)
+   {
+      double binEnergy = exp(logLow + bin / _hashInverseDelta);
+      while (unionIndex < numUnion-1 && _unionEnergy[unionIndex+1] <= binEnergy)
+         unionIndex++;
+      _hashIndex[bin] = unionIndex;
+   }
+}
+
 // Then call this for each reaction to set cross section values
 void NuclearDataSpecies::addReaction(
    NuclearDataReaction::Enum type, double nuBar,
@@ -102,7 +340,14 @@ void NuclearDataSpecies::addReaction(
 
 
 // Set up the energies boundaries of the neutron
-NuclearData::NuclearData(int numGroups, double energyLow, double energyHigh) : _energies( numGroups+1,VAR_MEM)
+NuclearData::NuclearData(int numGroups, double energyLow, double energyHigh)
+: _energies( numGroups+1,VAR_MEM),
+  _checkEnergyGroup(0),
+  _computeCrossSections(0),
+  _multigroupTransfer(0),
+  _groupEnergy(numGroups, VAR_MEM),
+  _groupSpeed(numGroups, VAR_MEM),
+  _continuousEnergy(0)
 {
    qs_assert (energyLow < energyHigh);
    _numEnergyGroups = numGroups;
@@ -116,6 +361,17 @@ NuclearData::NuclearData(int numGroups, double energyLow, double energyHigh) : _
       double logValue = logLow + delta *energyIndex;
       _energies[energyIndex] = exp(logValue);
    }
+   _logEnergyLow = logLow;
+   _inverseLogDelta = 1.0 / delta;
+
+   double restMass = PhysicalConstants::_neutronRestMassEnergy;
+   for (int group = 0; group < numGroups; group++)
+   {
+      double energy = (_energies[group] + _energies[group+1]) / 2.0;
+      _groupEnergy[group] = energy;
+      _groupSpeed[group] = PhysicalConstants::_speedOfLight *
+         sqrt(1.0 - (restMass * restMass) / ((energy + restMass) * (energy + restMass)));
+   }
 }
 
 int NuclearData::addIsotope(
@@ -127,9 +383,7 @@ int NuclearData::addIsotope(
    double totalCrossSection,
    double fissionWeight, double scatterWeight, double absorptionWeight)
 {
-   _isotopes.Open();
-   _isotopes.push_back(NuclearDataIsotope());
-   _isotopes.Close();
+   NuclearDataIsotope isotope;
 
    double totalWeight = fissionWeight + scatterWeight + absorptionWeight;
 
@@ -153,7 +407,7 @@ int NuclearData::addIsotope(
    double scatterCrossSection    = (totalCrossSection * scatterWeight)    / (nScatter    * totalWeight);
    double absorptionCrossSection = (totalCrossSection * absorptionWeight) / (nAbsorption * totalWeight);
 
-   _isotopes.back()._species[0]._reactions.reserve( nReactions, VAR_MEM);
+   isotope._species[0]._reactions.reserve( nReactions, VAR_MEM);
 
    for (int ii=0; ii<nReactions; ++ii)
    {
@@ -179,11 +433,69 @@ int NuclearData::addIsotope(
          reactionCrossSection = absorptionCrossSection;
          break;
       }
-      _isotopes.back()._species[0].addReaction(type, nuBar, _energies, polynomial, reactionCrossSection);
+      isotope._species[0].addReaction(type, nuBar, _energies, polynomial, reactionCrossSection);
+   }
+
+   // Share the data of an earlier isotope if it is identical.
+   int dataIndex = 0;
+   while (dataIndex < _isotopes.size() && !sameIsotopeData(_isotopes[dataIndex], isotope))
+      dataIndex++;
+   if (dataIndex == _isotopes.size())
+   {
+      _isotopes.Open();
+      _isotopes.push_back(isotope);
+      _isotopes.Close();
    }
-   
 
-   return _isotopes.size() - 1;
+   _isotopeData.Open();
+   _isotopeData.push_back(dataIndex);
+   _isotopeData.Close();
+
+   return _isotopeData.size() - 1;
+}
+
+// Copy the cross sections of every isotope into _crossSectionTable.
+// The accessors below read only the table, so call this after the
+// last addIsotope.
+void NuclearData::buildCrossSectionTable()
+{
+   int numData = _isotopes.size();
+   qs_vector<int> dataOffset(numData);
+
+   int tableSize = 0;
+   for (int dataIndex = 0; dataIndex < numData; dataIndex++)
+   {
+      dataOffset[dataIndex] = tableSize;
+      tableSize += _numEnergyGroups * (_isotopes[dataIndex]._species[0]._reactions.size() + 1);
+   }
+   _crossSectionTable.resize(tableSize, VAR_MEM);
+
+   int numIsotopes = _isotopeData.size();
+   _isotopeOffset.resize(numIsotopes, VAR_MEM);
+   _numReactions.resize(numIsotopes, VAR_MEM);
+   for (int isoIndex = 0; isoIndex < numIsotopes; isoIndex++)
+   {
+      int dataIndex = _isotopeData[isoIndex];
+      _isotopeOffset[isoIndex] = dataOffset[dataIndex];
+      _numReactions[isoIndex] = _isotopes[dataIndex]._species[0]._reactions.size();
+   }
+
+   for (int dataIndex = 0; dataIndex < numData; dataIndex++)
+   {
+      qs_vector<NuclearDataReaction>& reactions = _isotopes[dataIndex]._species[0]._reactions;
+      int numReacts = reactions.size();
+      for (int group = 0; group < _numEnergyGroups; group++)
+      {
+         CrossSectionReal* row = &_crossSectionTable[dataOffset[dataIndex] + group*(numReacts+1)];
+         double totalCrossSection = 0.0;
+         for (int reactIndex = 0; reactIndex < numReacts; reactIndex++)
+         {
+            row[reactIndex+1] = reactions[reactIndex].getCrossSection(group);
+            totalCrossSection += row[reactIndex+1];
+         }
+         row[0] = totalCrossSection;
+      }
+   }
 }
 
 HOST_DEVICE
@@ -195,11 +507,28 @@ double NuclearDataReaction::getCrossSection(unsigned int group)
 }
 HOST_DEVICE_END
 
+HOST_DEVICE
+// Evaluate the cross section at this energy.  This is the value the
+// constructor tabulates at the group midpoints.
+double NuclearDataReaction::computeCrossSection(double log10Energy)
+{
+   return pow( 10, _polynomial(log10Energy)) * _scale;
+}
+HOST_DEVICE_END
+
 HOST_DEVICE
 int NuclearData::getNumberReactions(unsigned int isotopeIndex)
 {
-   qs_assert(isotopeIndex < _isotopes.size());
-   return (int)_isotopes[isotopeIndex]._species[0]._reactions.size();
+   qs_assert((int) isotopeIndex < _numReactions.size());
+   return _numReactions[isotopeIndex];
+}
+HOST_DEVICE_END
+
+HOST_DEVICE
+NuclearDataReaction& NuclearData::getReaction(unsigned int reactIndex, unsigned int isotopeIndex)
+{
+   qs_assert((int) isotopeIndex < _isotopeData.size());
+   return _isotopes[_isotopeData[isotopeIndex]]._species[0]._reactions[reactIndex];
 }
 HOST_DEVICE_END
 
@@ -211,6 +540,34 @@ int NuclearData::getEnergyGroup(double energy)
    if (energy <= _energies[0]) return 0;
    if (energy > _energies[numEnergies-1]) return numEnergies-1;
 
+   // The log-uniform guess can be off by one where rounding puts
+   // energy next to a boundary, and it lands in the last group for
+   // energies above _energies[numEnergies-2].  Step to the group with
+   // _energies[group] <= energy < _energies[group+1].
+   int group = (int)((log(energy) - _logEnergyLow) * _inverseLogDelta);
+   if (group > numEnergies-2) group = numEnergies-2;
+   if (group < 0) group = 0;
+   while (group > 0 && energy < _energies[group])
+      group--;
+   while (group < numEnergies-2 && energy >= _energies[group+1])
+      group++;
+
+   if (_checkEnergyGroup)
+      qs_assert(group == searchEnergyGroup(energy));
+
+   return group;
+}
+HOST_DEVICE_END
+
+// For this energy, return the group index found by a binary search
+// of the group boundaries.
+HOST_DEVICE
+int NuclearData::searchEnergyGroup(double energy)
+{
+   int numEnergies = (int)_energies.size();
+   if (energy <= _energies[0]) return 0;
+   if (energy > _energies[numEnergies-1]) return numEnergies-1;
+
    int high = numEnergies-1;
    int low = 0;
 
@@ -227,30 +584,98 @@ int NuclearData::getEnergyGroup(double energy)
 }
 HOST_DEVICE_END
 
+// Return log10 of the energy at the middle of the group, where the
+// cross sections are evaluated.
+HOST_DEVICE
+double NuclearData::getGroupLog10Energy(unsigned int group)
+{
+   qs_assert((int) group < _numEnergyGroups);
+   return log10((_energies[group] + _energies[group+1]) / 2.0);
+}
+HOST_DEVICE_END
+
 // General routines to help access data lower down
 // Return the total cross section for this energy group
 HOST_DEVICE
 double NuclearData::getTotalCrossSection(unsigned int isotopeIndex, unsigned int group)
 {
-   qs_assert(isotopeIndex < _isotopes.size());
-   int numReacts = (int)_isotopes[isotopeIndex]._species[0]._reactions.size();
-   double totalCrossSection = 0.0;
-   for (int reactIndex = 0; reactIndex < numReacts; reactIndex++)
+   qs_assert((int) isotopeIndex < _numReactions.size());
+   if (_computeCrossSections)
    {
-      totalCrossSection += _isotopes[isotopeIndex]._species[0]._reactions[reactIndex].getCrossSection(group);
+      double log10Energy = getGroupLog10Energy(group);
+      double totalCrossSection = 0.0;
+      for (int reactIndex = 0; reactIndex < _numReactions[isotopeIndex]; reactIndex++)
+         totalCrossSection += getReaction(reactIndex, isotopeIndex).computeCrossSection(log10Energy);
+      return totalCrossSection;
    }
-   return totalCrossSection;
+   return _crossSectionTable[_isotopeOffset[isotopeIndex] + group*(_numReactions[isotopeIndex]+1)];
 }
 HOST_DEVICE_END
 
-// Return the total cross section for this energy group
+// Return the union grid point at or below this energy.  The hash bin
+// bounds the binary search; the final steps absorb rounding in the bin
+// computation.
+HOST_DEVICE
+int NuclearData::getUnionIndex(double energy)
+{
+   int numUnion = _unionEnergy.size();
+   int numBins = _hashIndex.size() - 1;
+   if (energy <= _unionEnergy[0]) return 0;
+   if (energy >= _unionEnergy[numUnion-1]) return numUnion-1;
+
+   int bin = (int)((log(energy) - _logEnergyLow) * _hashInverseDelta);
+   if (bin < 0) bin = 0;
+   if (bin > numBins-1) bin = numBins-1;
+   int low = _hashIndex[bin];
+   int high = _hashIndex[bin+1] + 1;
+   if (high > numUnion-1) high = numUnion-1;
+   while (high > low+1)
+   {
+      int mid = (high+low)/2;
+      if (energy < _unionEnergy[mid])
+         high = mid;
+      else
+         low = mid;
+   }
+   while (low > 0 && energy < _unionEnergy[low])
+      low--;
+   while (low < numUnion-1 && energy >= _unionEnergy[low+1])
+      low++;
+   return low;
+}
+HOST_DEVICE_END
+
+// Interpolate the pointwise cross section of this isotope linearly in
+// energy.  A reactIndex of -1 means total cross section.
+HOST_DEVICE
+double NuclearData::getPointwiseCrossSection(
+   int reactIndex, unsigned int isotopeIndex, int unionIndex, double energy)
+{
+   qs_assert((int) isotopeIndex < _isotopeData.size());
+   int numData = _isotopes.size();
+   int dataIndex = _isotopeData[isotopeIndex];
+   int point = _unionIndex[unionIndex*numData + dataIndex];
+   const double* pointEnergy = &_pointEnergy[_pointOffset[dataIndex] + point];
+   int width = _numReactions[isotopeIndex] + 1;
+   const CrossSectionReal* value = &_pointValue[_pointValueOffset[dataIndex] + point*width + reactIndex + 1];
+
+   double fraction = (energy - pointEnergy[0]) / (pointEnergy[1] - pointEnergy[0]);
+   if (fraction < 0.0) fraction = 0.0;
+   if (fraction > 1.0) fraction = 1.0;
+   return value[0] + fraction * (value[width] - value[0]);
+}
+HOST_DEVICE_END
+
+// Return the reaction cross section for this energy group
 HOST_DEVICE
 double NuclearData::getReactionCrossSection(
    unsigned int reactIndex, unsigned int isotopeIndex, unsigned int group)
 {
-   qs_assert(isotopeIndex < _isotopes.size());
-   qs_assert(reactIndex < _isotopes[isotopeIndex]._species[0]._reactions.size());
-   return _isotopes[isotopeIndex]._species[0]._reactions[reactIndex].getCrossSection(group);
+   qs_assert((int) isotopeIndex < _numReactions.size());
+   qs_assert((int) reactIndex < _numReactions[isotopeIndex]);
+   if (_computeCrossSections)
+      return getReaction(reactIndex, isotopeIndex).computeCrossSection(getGroupLog10Energy(group));
+   return _crossSectionTable[_isotopeOffset[isotopeIndex] + group*(_numReactions[isotopeIndex]+1) + 1 + reactIndex];
 }
 HOST_DEVICE_END
 
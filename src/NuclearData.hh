@@ -3,20 +3,27 @@
 
 #include <cstdio>
 #include <string>
+#include <vector>
 #include "QS_Vector.hh"
 #include <cstdlib>
 #include <cmath>
 #include <algorithm>
 #include "qs_assert.hh"
 #include "DeclareMacro.hh"
+#include "portability.hh"
 
 class Polynomial
 {
  public:
+   Polynomial()
+   :
+   _aa(0.), _bb(0.), _cc(0.), _dd(0.), _ee(0.){}
+
    Polynomial(double aa, double bb, double cc, double dd, double ee)
    :
    _aa(aa), _bb(bb), _cc(cc), _dd(dd), _ee(ee){}
 
+   HOST_DEVICE_CUDA
    double operator()(double xx) const
    {
       return _ee + xx * (_dd + xx * (_cc + xx * (_bb + xx * (_aa))));
@@ -26,6 +33,33 @@ class Polynomial
    double _aa, _bb, _cc, _dd, _ee;
 };
 
+// Group to group transfer probabilities stored as one cumulative
+// distribution per incident group.  Only the band of outgoing groups
+// with nonzero probability is kept: row ii covers the groups from
+// _firstGroup[ii] on and its entries are _cdf[_rowOffset[ii]] up to
+// _cdf[_rowOffset[ii+1]-1].
+class GroupTransfer
+{
+ public:
+
+   void setRows(const std::vector<std::vector<double> >& probability);
+
+   // Return the outgoing group for a random number in [0,1).
+   HOST_DEVICE_CUDA
+   int sample(int row, double randomNumber) const
+   {
+      int index = _rowOffset[row];
+      int last = _rowOffset[row+1] - 1;
+      while (index < last && randomNumber >= _cdf[index])
+         index++;
+      return _firstGroup[row] + index - _rowOffset[row];
+   }
+
+   qs_vector<int> _firstGroup;
+   qs_vector<int> _rowOffset;
+   qs_vector<double> _cdf;
+};
+
 // Lowest level class at the reaction level
 class NuclearDataReaction
 {
@@ -48,11 +82,18 @@ class NuclearDataReaction
    HOST_DEVICE_CUDA
    double getCrossSection(unsigned int group);
    HOST_DEVICE_CUDA
+   double computeCrossSection(double log10Energy);
+   HOST_DEVICE_CUDA
    void sampleCollision(double incidentEnergy, double material_mass, double* energyOut,
                         double* angleOut, int &nOut, uint64_t* seed, int max_production_size);
+   HOST_DEVICE_CUDA
+   void sampleCollisionGroup(int incidentGroup, const GroupTransfer& transfer, int* groupOut,
+                             double* angleOut, int &nOut, uint64_t* seed, int max_production_size);
    
    
    qs_vector<double> _crossSection; //!< tabular data for microscopic cross section
+   Polynomial _polynomial;            //!< log10 cross section as a function of log10 energy
+   double _scale;                     //!< normalization applied to the polynomial
    Enum _reactionType;                //!< What type of reaction is this
    double _nuBar;                     //!< If this is a fission, specify the nu bar
 
@@ -96,23 +137,90 @@ class NuclearData
                   double totalCrossSection,
                   double fissionWeight, double scatterWeight, double absorptionWeight);
 
+   void buildCrossSectionTable();
+   void buildScatterTransfer(double material_mass, GroupTransfer& transfer);
+   void buildFissionTransfer();
+   void buildPointwiseTables(int numPoints);
+
    HOST_DEVICE_CUDA
    int getEnergyGroup(double energy);
    HOST_DEVICE_CUDA
+   int searchEnergyGroup(double energy);
+   HOST_DEVICE_CUDA
    int getNumberReactions(unsigned int isotopeIndex);
    HOST_DEVICE_CUDA
+   NuclearDataReaction& getReaction(unsigned int reactIndex, unsigned int isotopeIndex);
+   HOST_DEVICE_CUDA
+   double getGroupLog10Energy(unsigned int group);
+   HOST_DEVICE_CUDA
    double getTotalCrossSection(unsigned int isotopeIndex, unsigned int group);
    HOST_DEVICE_CUDA
    double getReactionCrossSection(unsigned int reactIndex, unsigned int isotopeIndex, unsigned int group);
 
+   HOST_DEVICE_CUDA
+   int getUnionIndex(double energy);
+   HOST_DEVICE_CUDA
+   double getPointwiseCrossSection(int reactIndex, unsigned int isotopeIndex, int unionIndex, double energy);
+
    int _numEnergyGroups;
    // Store the cross sections and reactions by isotope, which stores
-   // it by species
+   // it by species.  Isotopes with identical data share one entry;
+   // _isotopeData maps each isotope gid to its entry.
    qs_vector<NuclearDataIsotope> _isotopes;
+   qs_vector<int> _isotopeData;
    // This is the overall energy layout. If we had more than just
    // neutrons, this array would be a vector of vectors.
    qs_vector<double> _energies;
 
+   // Contiguous copy of the reaction cross sections, built by
+   // buildCrossSectionTable once all isotopes are added.  For each
+   // entry of _isotopes and group it holds the total followed by the
+   // reaction cross sections, so the row of group gg of isotope gid ii
+   // starts at _isotopeOffset[ii] + gg*(_numReactions[ii]+1).  Both
+   // arrays are indexed by gid.
+   qs_vector<CrossSectionReal> _crossSectionTable;
+   qs_vector<int> _isotopeOffset;
+   qs_vector<int> _numReactions;
+
+   // The group boundaries are log-uniform, so getEnergyGroup computes
+   // the group from log(energy) and only checks the neighbors.
+   double _logEnergyLow;
+   double _inverseLogDelta;
+   // When set, getEnergyGroup compares every result against
+   // searchEnergyGroup.
+   int _checkEnergyGroup;
+   // When set, cross sections are evaluated from the reaction
+   // polynomials instead of read from the tables.
+   int _computeCrossSections;
+
+   // When set, collisions sample the outgoing group from transfer
+   // tables and give the particle the energy and speed of the group
+   // midpoint.  Scatter tables are per material (they depend on the
+   // mass); the fission spectrum has a single row.
+   int _multigroupTransfer;
+   GroupTransfer _fissionTransfer;
+   qs_vector<double> _groupEnergy;
+   qs_vector<double> _groupSpeed;
+
+   // Continuous-energy data, built by buildPointwiseTables when
+   // _continuousEnergy is set.  Each entry of _isotopes has its own
+   // grid of _pointEnergy values starting at _pointOffset[dd], with a
+   // row of total and reaction cross sections per point starting at
+   // _pointValueOffset[dd].  _unionEnergy is the sorted union of all
+   // grids; _unionIndex[uu*_isotopes.size() + dd] is the point of grid
+   // dd at or below _unionEnergy[uu].  _hashIndex splits log(energy)
+   // into equal bins and holds the union point at or below the start
+   // of each bin, so getUnionIndex only searches inside one bin.
+   int _continuousEnergy;
+   qs_vector<int> _pointOffset;
+   qs_vector<int> _pointValueOffset;
+   qs_vector<double> _pointEnergy;
+   qs_vector<CrossSectionReal> _pointValue;
+   qs_vector<double> _unionEnergy;
+   qs_vector<int> _unionIndex;
+   qs_vector<int> _hashIndex;
+   double _hashInverseDelta;
+
 };
 
 #endif
@@ -145,5 +253,5 @@ class NuclearData
 // table NAME2
 //
 // Each isotope inside a material will have identical cross sections.
-// However, it will be treated as unique in the nuclear data.
+// It keeps its own gid, but its data is only stored once.
 // Cross sectionsare strings that refer to tables
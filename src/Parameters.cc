@@ -32,6 +32,7 @@
 #include "parseUtils.hh"
 #include "InputBlock.hh"
 #include "utilsMpi.hh"
+#include "utils.hh"
 
 using std::string;
 using std::ifstream;
@@ -46,6 +47,7 @@ namespace
    void parseCommandLine(int argc, char** argv, Parameters& pp);
    void parseInputFile(const string& filename, Parameters& pp);
    void supplyDefaults(Parameters& params);
+   void checkTrackingModes(Parameters& params);
 
    void scanSimulationBlock  (const InputBlock& input, Parameters& pp);
    void scanGeometryBlock    (const InputBlock& input, Parameters& pp);
@@ -90,6 +92,7 @@ Parameters getParameters(int argc, char** argv)
    if( xsecOut != "" )    params.simulationParams.crossSectionsOut = xsecOut;
 
    supplyDefaults(params);
+   checkTrackingModes(params);
 
    return params;
 }
@@ -147,7 +150,17 @@ ostream& operator<<(ostream& out, const SimulationParameters& pp)
    out << "   bTally: " << pp.balanceTallyReplications << "\n";
    out << "   fTally: " << pp.fluxTallyReplications << "\n";
    out << "   cTally: " << pp.cellTallyReplications << "\n";
+   out << "   threadTallies: " << pp.threadTallies << "\n";
    out << "   coralBenchmark: " << pp.coralBenchmark << "\n";
+   out << "   eventTracking: " << pp.eventTracking << "\n";
+   out << "   workStealing: " << pp.workStealing << "\n";
+   out << "   sortParticles: " << pp.sortParticles << "\n";
+   out << "   mpiProgressThread: " << pp.mpiProgressThread << "\n";
+   out << "   checkEnergyGroups: " << pp.checkEnergyGroups << "\n";
+   out << "   computeCrossSections: " << pp.computeCrossSections << "\n";
+   out << "   multigroupTransfer: " << pp.multigroupTransfer << "\n";
+   out << "   continuousEnergy: " << pp.continuousEnergy << "\n";
+   out << "   nPoints: " << pp.nPoints << "\n";
    out << "   crossSectionsOut:" << pp.crossSectionsOut << "\n";
    out << endl;
    return out;
@@ -253,6 +266,16 @@ namespace
       addArg("bTally",           'B', 1, 'i', &(sp.balanceTallyReplications), 0, "number of balance tally replications");
       addArg("fTally",           'F', 1, 'i', &(sp.fluxTallyReplications),    0, "number of scalar flux tally replications");
       addArg("cTally",           'C', 1, 'i', &(sp.cellTallyReplications),    0, "number of scalar cell tally replications");
+      addArg("threadTallies",     0,  0, 'i', &(sp.threadTallies),            0, "one replication of every tally per thread, no atomics");
+      addArg("eventTracking",     0,  0, 'i', &(sp.eventTracking), 0,    "enable event-based tracking (cpu only)");
+      addArg("workStealing",      0,  1, 'i', &(sp.workStealing),  0,    "cpu tracking schedule: 0 static, 1 work-stealing, 2 static with idle time report");
+      addArg("sortParticles",     0,  1, 'i', &(sp.sortParticles), 0,    "sort particles before tracking: 0 off, 1 by cell, 2 by cell and energy group");
+      addArg("mpiProgressThread", 0,  0, 'i', &(sp.mpiProgressThread), 0,  "use one thread per rank for particle communication during tracking");
+      addArg("checkEnergyGroups", 0,  0, 'i', &(sp.checkEnergyGroups), 0,  "check every energy group lookup against a binary search");
+      addArg("computeCrossSections", 0, 0, 'i', &(sp.computeCrossSections), 0, "evaluate cross sections from their polynomials instead of tables");
+      addArg("multigroupTransfer", 0,  0, 'i', &(sp.multigroupTransfer), 0, "sample outgoing energy groups from group transfer tables");
+      addArg("continuousEnergy",  0,  0, 'i', &(sp.continuousEnergy),  0,  "use pointwise cross sections on a unionized energy grid");
+      addArg("nPoints",           0,  1, 'i', &(sp.nPoints),           0,  "number of pointwise energies per isotope");
 
       processArgs(argc, argv);
 
@@ -379,6 +402,34 @@ namespace
    }
 }
 
+namespace
+{
+   // Event based tracking, the MPI progress thread, and work stealing
+   // are alternative ways to track a vault on the cpu, so at most one of
+   // them can be in effect.  When several are requested keep the first
+   // of eventTracking, mpiProgressThread, workStealing, warn about the
+   // others and switch them off.
+   void checkTrackingModes(Parameters& params)
+   {
+      SimulationParameters& sp = params.simulationParams;
+      const char* winner = NULL;
+      if      ( sp.eventTracking )     winner = "eventTracking";
+      else if ( sp.mpiProgressThread ) winner = "mpiProgressThread";
+      else                             return;
+
+      if ( sp.eventTracking && sp.mpiProgressThread )
+      {
+         Print0("Warning: mpiProgressThread is ignored with %s\n", winner);
+         sp.mpiProgressThread = 0;
+      }
+      if ( sp.workStealing )
+      {
+         Print0("Warning: workStealing is ignored with %s\n", winner);
+         sp.workStealing = 0;
+      }
+   }
+}
+
 namespace
 {
    void scanSimulationBlock(const InputBlock& input, Parameters& pp)
@@ -413,7 +464,17 @@ namespace
       input.getValue<int>("bTally",sp.balanceTallyReplications);
       input.getValue<int>("fTally",sp.fluxTallyReplications);
       input.getValue<int>("cTally",sp.cellTallyReplications);
+      input.getValue<int>("threadTallies",sp.threadTallies);
       input.getValue<int>("coralBenchmark",sp.coralBenchmark);
+      input.getValue<int>("eventTracking",sp.eventTracking);
+      input.getValue<int>("workStealing",sp.workStealing);
+      input.getValue<int>("sortParticles",sp.sortParticles);
+      input.getValue<int>("mpiProgressThread",sp.mpiProgressThread);
+      input.getValue<int>("checkEnergyGroups",sp.checkEnergyGroups);
+      input.getValue<int>("computeCrossSections",sp.computeCrossSections);
+      input.getValue<int>("multigroupTransfer",sp.multigroupTransfer);
+      input.getValue<int>("continuousEnergy",sp.continuousEnergy);
+      input.getValue<int>("nPoints",sp.nPoints);
 
    }
 }
@@ -130,7 +130,17 @@ struct SimulationParameters
      balanceTallyReplications(1),
      fluxTallyReplications(1),
      cellTallyReplications(1),
-     coralBenchmark(0)
+     threadTallies(0),
+     coralBenchmark(0),
+     eventTracking(0),
+     workStealing(0),
+     sortParticles(0),
+     mpiProgressThread(0),
+     checkEnergyGroups(0),
+     computeCrossSections(0),
+     multigroupTransfer(0),
+     continuousEnergy(0),
+     nPoints(10000)
    {};
 
    std::string inputFile;        //!< name of input file
@@ -163,7 +173,17 @@ struct SimulationParameters
    int balanceTallyReplications; //!< Number of replications for the balance tallies
    int fluxTallyReplications;    //!< Number of replications for the scalar flux tally
    int cellTallyReplications;    //!< Number of replications for the scalar cell tally
+   int threadTallies;            //!< give each thread its own replication of every tally
    int coralBenchmark;           //!< enable correctness check for Coral2 benchmark
+   int eventTracking;            //!< enable event-based (instead of history-based) tracking on the cpu
+   int workStealing;             //!< cpu tracking schedule: 0 omp static, 1 work-stealing, 2 static with idle time report
+   int sortParticles;            //!< sort particles before tracking: 0 off, 1 by cell, 2 by cell and energy group
+   int mpiProgressThread;        //!< dedicate one thread per rank to particle communication during tracking
+   int checkEnergyGroups;        //!< cross-check the direct energy group lookup against a binary search
+   int computeCrossSections;     //!< evaluate cross sections from their polynomials instead of tables
+   int multigroupTransfer;       //!< sample outgoing groups of collisions from group transfer tables
+   int continuousEnergy;         //!< track with pointwise (instead of multigroup) cross sections
+   int nPoints;                  //!< number of pointwise energies per isotope in continuous-energy mode
 };
 
 struct Parameters
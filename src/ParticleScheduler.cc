@@ -0,0 +1,207 @@
+#include "ParticleScheduler.hh"
+#include "MonteCarlo.hh"
+#include "ParticleVault.hh"
+#include "CycleTracking.hh"
+#include "MC_Processor_Info.hh"
+#include "utilsMpi.hh"
+#include "macros.hh"
+#include <cstdio>
+
+namespace
+{
+    double wallTime()
+    {
+#ifdef HAVE_OPENMP
+        return omp_get_wtime();
+#else
+        return mpiWtime();
+#endif
+    }
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+ParticleScheduler::ParticleScheduler( bool steal )
+: _steal(steal),
+  _numThreads(omp_get_max_threads()),
+  _grainSize(16),
+  _queue(_numThreads)
+{
+    for ( int thread = 0; thread < _numThreads; thread++ )
+    {
+#ifdef HAVE_OPENMP
+        omp_init_lock( &_queue[thread].lock );
+#endif
+        _queue[thread].idleTime = 0.0;
+        _queue[thread].busyTime = 0.0;
+    }
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+ParticleScheduler::~ParticleScheduler()
+{
+#ifdef HAVE_OPENMP
+    for ( int thread = 0; thread < _numThreads; thread++ )
+        omp_destroy_lock( &_queue[thread].lock );
+#endif
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+// Take the next chunk of at most _grainSize particles off the front of this
+// thread's own deque.
+//----------------------------------------------------------------------------------------------------------------------
+bool ParticleScheduler::popWork( int thread, Range &range )
+{
+    ThreadQueue &queue = _queue[thread];
+    bool found = false;
+
+#ifdef HAVE_OPENMP
+    omp_set_lock( &queue.lock );
+#endif
+    if ( !queue.ranges.empty() )
+    {
+        Range &front = queue.ranges.front();
+        range.begin = front.begin;
+        if ( front.end - front.begin > _grainSize )
+        {
+            range.end = front.begin + _grainSize;
+            front.begin = range.end;
+        }
+        else
+        {
+            range.end = front.end;
+            queue.ranges.pop_front();
+        }
+        found = true;
+    }
+#ifdef HAVE_OPENMP
+    omp_unset_lock( &queue.lock );
+#endif
+
+    return found;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+// Steal from the back of another thread's deque.  Ranges larger than a chunk
+// are split in half and the victim keeps the lower half.  The stolen range
+// goes onto this thread's own deque so that it can be stolen from in turn.
+//----------------------------------------------------------------------------------------------------------------------
+bool ParticleScheduler::stealWork( int thread, Range &range )
+{
+    for ( int offset = 1; offset < _numThreads; offset++ )
+    {
+        ThreadQueue &victim = _queue[(thread + offset) % _numThreads];
+        bool found = false;
+        Range stolen;
+
+#ifdef HAVE_OPENMP
+        omp_set_lock( &victim.lock );
+#endif
+        if ( !victim.ranges.empty() )
+        {
+            Range &back = victim.ranges.back();
+            stolen.end = back.end;
+            if ( back.end - back.begin > _grainSize )
+            {
+                stolen.begin = back.begin + (back.end - back.begin) / 2;
+                back.end = stolen.begin;
+            }
+            else
+            {
+                stolen.begin = back.begin;
+                victim.ranges.pop_back();
+            }
+            found = true;
+        }
+#ifdef HAVE_OPENMP
+        omp_unset_lock( &victim.lock );
+#endif
+
+        if ( found )
+        {
+            ThreadQueue &queue = _queue[thread];
+#ifdef HAVE_OPENMP
+            omp_set_lock( &queue.lock );
+#endif
+            queue.ranges.push_back( stolen );
+#ifdef HAVE_OPENMP
+            omp_unset_lock( &queue.lock );
+#endif
+            return popWork( thread, range );
+        }
+    }
+    return false;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+// Track every particle in the processing vault.  A thread's idle time is the
+// part of the parallel region it spent neither tracking nor able to find work.
+//----------------------------------------------------------------------------------------------------------------------
+void ParticleScheduler::trackVault( MonteCarlo *monteCarlo, ParticleVault *processingVault, ParticleVault *processedVault )
+{
+    int numParticles = processingVault->size();
+
+    // Start every thread with the block a static schedule would have given it.
+    for ( int thread = 0; thread < _numThreads; thread++ )
+    {
+        Range block;
+        block.begin = (int)( (int64_t)numParticles *  thread      / _numThreads );
+        block.end   = (int)( (int64_t)numParticles * (thread + 1) / _numThreads );
+        _queue[thread].ranges.clear();
+        if ( block.end > block.begin )
+            _queue[thread].ranges.push_back( block );
+    }
+
+#ifdef HAVE_OPENMP
+    #pragma omp parallel num_threads(_numThreads)
+#endif
+    {
+        int thread = omp_get_thread_num();
+        double start = wallTime();
+        double busy = 0.0;
+
+        Range range;
+        while ( popWork( thread, range ) || ( _steal && stealWork( thread, range ) ) )
+        {
+            double chunkStart = wallTime();
+            for ( int particle_index = range.begin; particle_index < range.end; particle_index++ )
+            {
+                CycleTrackingGuts( monteCarlo, particle_index, processingVault, processedVault );
+            }
+            busy += wallTime() - chunkStart;
+        }
+
+#ifdef HAVE_OPENMP
+        #pragma omp barrier
+#endif
+        _queue[thread].busyTime += busy;
+        _queue[thread].idleTime += ( wallTime() - start ) - busy;
+    }
+
+    // If the runtime gave us fewer threads than asked for, some blocks were
+    // never started (without stealing).  Track whatever is left.
+    for ( int thread = 0; thread < _numThreads; thread++ )
+    {
+        Range range;
+        while ( popWork( thread, range ) )
+        {
+            for ( int particle_index = range.begin; particle_index < range.end; particle_index++ )
+                CycleTrackingGuts( monteCarlo, particle_index, processingVault, processedVault );
+        }
+    }
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+void ParticleScheduler::printIdleTime( MonteCarlo *monteCarlo )
+{
+    if ( monteCarlo->processor_info->rank != 0 ) { return; }
+
+    fprintf( stdout, "\nTracking thread idle time on rank 0 (%s schedule)\n", _steal ? "work-stealing" : "static" );
+    fprintf( stdout, "thread        busy (s)        idle (s)      idle (%%)\n" );
+    for ( int thread = 0; thread < _numThreads; thread++ )
+    {
+        double total = _queue[thread].busyTime + _queue[thread].idleTime;
+        fprintf( stdout, "%6d %15.6f %15.6f %13.2f\n", thread,
+                 _queue[thread].busyTime, _queue[thread].idleTime,
+                 total > 0.0 ? 100.0 * _queue[thread].idleTime / total : 0.0 );
+    }
+}
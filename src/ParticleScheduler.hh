@@ -0,0 +1,75 @@
+#ifndef PARTICLE_SCHEDULER_HH
+#define PARTICLE_SCHEDULER_HH
+
+#include <deque>
+#include <vector>
+
+#ifdef HAVE_OPENMP
+#include <omp.h>
+#endif
+
+class MonteCarlo;
+class ParticleVault;
+
+//---------------------------------------------------------------
+// ParticleScheduler distributes the particles of a processing
+// vault over the OpenMP threads of the cpu tracking loop.
+//
+// Every thread owns a deque of particle index ranges.  It starts
+// with the same contiguous block a static schedule would give it
+// and takes small chunks off the front of its own deque.  When
+// its deque is empty it steals from the back of another thread's
+// deque, splitting the victim's range in half, so long histories
+// at the end of one block no longer leave the other threads idle.
+//
+// With stealing disabled the scheduler runs the plain static
+// blocks, which gives a baseline for the idle time report.
+//---------------------------------------------------------------
+
+class ParticleScheduler
+{
+  public:
+
+    ParticleScheduler( bool steal );
+    ~ParticleScheduler();
+
+    // Track all particles in processingVault (CycleTrackingGuts on each index)
+    void trackVault( MonteCarlo *monteCarlo, ParticleVault *processingVault, ParticleVault *processedVault );
+
+    // Print per thread idle time accumulated over all calls to trackVault
+    void printIdleTime( MonteCarlo *monteCarlo );
+
+  private:
+
+    struct Range
+    {
+        int begin;
+        int end;
+    };
+
+    // Per thread state, padded to avoid false sharing between threads
+    struct ThreadQueue
+    {
+        std::deque<Range> ranges;
+#ifdef HAVE_OPENMP
+        omp_lock_t lock;
+#endif
+        double idleTime;
+        double busyTime;
+        char pad[64];
+    };
+
+    bool popWork( int thread, Range &range );
+    bool stealWork( int thread, Range &range );
+
+    bool _steal;
+    int _numThreads;
+    int _grainSize;
+    std::vector<ThreadQueue> _queue;
+
+    // Disable copy constructor and assignment operator
+    ParticleScheduler( const ParticleScheduler& );
+    ParticleScheduler& operator=( const ParticleScheduler& );
+};
+
+#endif
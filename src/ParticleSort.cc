@@ -0,0 +1,139 @@
+#include "ParticleSort.hh"
+#include "MonteCarlo.hh"
+#include "MC_Processor_Info.hh"
+#include "Globals.hh"
+#include "ParticleVaultContainer.hh"
+#include "ParticleVault.hh"
+#include "NuclearData.hh"
+#include "NVTX_Range.hh"
+#include "macros.hh"
+#include <vector>
+
+namespace
+{
+   // Sort keys and particle indices together with a stable LSD radix sort.
+   // Each pass histograms the digits of one contiguous block per thread, so
+   // the scatter keeps the input order within a digit.
+   void RadixSort(std::vector<uint64_t>& key, std::vector<int>& index, int keyBits)
+   {
+      const int radixBits = 8;
+      const int numBuckets = 1 << radixBits;
+      const int numParticles = key.size();
+      const int numBlocks = omp_get_max_threads();
+
+      std::vector<uint64_t> keyTmp(numParticles);
+      std::vector<int> indexTmp(numParticles);
+      std::vector<int> offset(numBlocks*numBuckets);
+
+      for (int shift = 0; shift < keyBits; shift += radixBits)
+      {
+         #include "mc_omp_parallel_for_schedule_static.hh"
+         for (int block = 0; block < numBlocks; block++)
+         {
+            int* count = &offset[block*numBuckets];
+            for (int bucket = 0; bucket < numBuckets; bucket++) { count[bucket] = 0; }
+
+            int begin = (int64_t)numParticles * block / numBlocks;
+            int end   = (int64_t)numParticles * (block+1) / numBlocks;
+            for (int ii = begin; ii < end; ii++)
+               count[(key[ii] >> shift) & (numBuckets-1)]++;
+         }
+
+         // Exclusive scan in (bucket, block) order
+         int sum = 0;
+         for (int bucket = 0; bucket < numBuckets; bucket++)
+         {
+            for (int block = 0; block < numBlocks; block++)
+            {
+               int count = offset[block*numBuckets + bucket];
+               offset[block*numBuckets + bucket] = sum;
+               sum += count;
+            }
+         }
+
+         #include "mc_omp_parallel_for_schedule_static.hh"
+         for (int block = 0; block < numBlocks; block++)
+         {
+            int* position = &offset[block*numBuckets];
+            int begin = (int64_t)numParticles * block / numBlocks;
+            int end   = (int64_t)numParticles * (block+1) / numBlocks;
+            for (int ii = begin; ii < end; ii++)
+            {
+               int dest = position[(key[ii] >> shift) & (numBuckets-1)]++;
+               keyTmp[dest] = key[ii];
+               indexTmp[dest] = index[ii];
+            }
+         }
+
+         key.swap(keyTmp);
+         index.swap(indexTmp);
+      }
+   }
+}
+
+// Sort keys:
+//   1: (domain, cell)
+//   2: (domain, cell, energy group)
+void SortProcessingParticles(MonteCarlo* monteCarlo)
+{
+   const int sortKey = monteCarlo->_params.simulationParams.sortParticles;
+   if (sortKey == 0) { return; }
+
+   NVTX_Range range("SortProcessingParticles");
+
+   ParticleVaultContainer* container = monteCarlo->_particleVaultContainer;
+   container->collapseProcessing();
+
+   const int numParticles = container->sizeProcessing();
+   const uint64_t vaultSize = container->getVaultSize();
+   if (numParticles < 2) { return; }
+
+   // Number the cells of all local domains consecutively.
+   std::vector<uint64_t> cellOffset(monteCarlo->domain.size() + 1, 0);
+   for (int domainIndex = 0; domainIndex < monteCarlo->domain.size(); domainIndex++)
+      cellOffset[domainIndex+1] = cellOffset[domainIndex] + monteCarlo->domain[domainIndex].cell_state.size();
+
+   // getEnergyGroup can return numEnergyGroups for energies above the grid.
+   const uint64_t numGroups = (sortKey == 2) ? monteCarlo->_nuclearData->_numEnergyGroups + 1 : 1;
+
+   uint64_t maxKey = cellOffset.back() * numGroups;
+   int keyBits = 0;
+   while (keyBits < 64 && (maxKey >> keyBits) != 0) { keyBits++; }
+
+   std::vector<uint64_t> key(numParticles);
+   std::vector<int> index(numParticles);
+
+   #include "mc_omp_parallel_for_schedule_static.hh"
+   for (int particleIndex = 0; particleIndex < numParticles; particleIndex++)
+   {
+      ParticleVault& vault = *(container->getTaskProcessingVault(particleIndex / vaultSize));
+      int vaultIndex = particleIndex % vaultSize;
+
+      uint64_t particleKey = cellOffset[vault.domain(vaultIndex)] + vault.cell(vaultIndex);
+      if (sortKey == 2)
+         particleKey = particleKey * numGroups + monteCarlo->_nuclearData->getEnergyGroup(vault.kineticEnergy(vaultIndex));
+
+      key[particleIndex] = particleKey;
+      index[particleIndex] = particleIndex;
+   }
+
+   RadixSort(key, index, keyBits);
+
+   // Gather the particles in sorted order, then write them back.
+   std::vector<MC_Base_Particle> sorted(numParticles);
+
+   #include "mc_omp_parallel_for_schedule_static.hh"
+   for (int particleIndex = 0; particleIndex < numParticles; particleIndex++)
+   {
+      int from = index[particleIndex];
+      const ParticleVault& vault = *(container->getTaskProcessingVault(from / vaultSize));
+      sorted[particleIndex] = vault[from % vaultSize];
+   }
+
+   #include "mc_omp_parallel_for_schedule_static.hh"
+   for (int particleIndex = 0; particleIndex < numParticles; particleIndex++)
+   {
+      ParticleVault& vault = *(container->getTaskProcessingVault(particleIndex / vaultSize));
+      vault.putBaseParticle(sorted[particleIndex], particleIndex % vaultSize);
+   }
+}
@@ -0,0 +1,11 @@
+#ifndef PARTICLE_SORT_HH
+#define PARTICLE_SORT_HH
+
+class MonteCarlo;
+
+// Reorder the processing vaults so that particles in the same
+// domain and cell (and optionally energy group) are tracked next to
+// each other.  The key is chosen by the sortParticles parameter.
+void SortProcessingParticles(MonteCarlo* monteCarlo);
+
+#endif
@@ -7,37 +7,70 @@
 
 #include <vector>
 
+//----------------------------------------------------------------------------------------------------------------------
+// A ParticleVault stores particles either as an array of MC_Base_Particle
+// records (the default) or, when compiled with -DSOA_VAULT, as one array per
+// particle field.  The SoA layout lets loops that only need a few fields
+// (population control, energy spectrum) stream just those fields.  Code
+// outside this class should use the accessors below rather than assume a
+// layout.
+//----------------------------------------------------------------------------------------------------------------------
 class ParticleVault
 {
 public:
 
+#ifndef SOA_VAULT
+   ParticleVault() {}
+#else
+   ParticleVault() : _size(0) {}
+#endif
+
    // Is the vault empty.
-   bool empty() const {return _particles.empty();}
+   bool empty() const {return size() == 0;}
 
    // Get the size of the vault.
    HOST_DEVICE_CUDA
+#ifndef SOA_VAULT
    size_t size() const {return _particles.size();}
+#else
+   size_t size() const {return _size;}
+#endif
 
    // Reserve the size for the container of particles.
-   void reserve(size_t n)
-   { 
-       _particles.reserve(n,VAR_MEM); 
-   }
+   void reserve(size_t n);
 
    // Add all particles in a 2nd vault into this vault.
-   void append (ParticleVault & vault2)
-        { _particles.appendList( vault2._particles.size(), &vault2._particles[0] ); }
+   void append (ParticleVault & vault2);
 
    void collapse( size_t fill_size, ParticleVault* vault2 );
 
    // Clear all particles from the vault
+#ifndef SOA_VAULT
    void clear() { _particles.clear(); } 
+#else
+   void clear() { _size = 0; }
+#endif
 
+#ifndef SOA_VAULT
    // Access particle at a given index.
    MC_Base_Particle& operator[](size_t n) {return _particles[n];}
+#endif
 
    // Access a particle at a given index.
+#ifndef SOA_VAULT
    const MC_Base_Particle& operator[](size_t n) const {return _particles[n];}
+#else
+   MC_Base_Particle operator[](size_t n) const {MC_Base_Particle particle; loadBaseParticle(particle, n); return particle;}
+#endif
+
+   // Access individual fields of the particle at a given index.
+   HOST_DEVICE_CUDA double&   weight(size_t n);
+   HOST_DEVICE_CUDA double&   kineticEnergy(size_t n);
+   HOST_DEVICE_CUDA uint64_t& randomNumberSeed(size_t n);
+   HOST_DEVICE_CUDA uint64_t& identifier(size_t n);
+   HOST_DEVICE_CUDA int&      species(size_t n);
+   HOST_DEVICE_CUDA int&      domain(size_t n);
+   HOST_DEVICE_CUDA int&      cell(size_t n);
 
    // Put a particle into the vault, down casting its class.
    HOST_DEVICE_CUDA
@@ -47,6 +80,10 @@ public:
    HOST_DEVICE_CUDA
    void pushBaseParticle(MC_Base_Particle &base_particle);
 
+   // Put count base particles into the vault with a single atomic update.
+   HOST_DEVICE_CUDA
+   void pushBaseParticles(const MC_Base_Particle *list, int count);
+
    // Get a base particle from the vault.
    bool popBaseParticle(MC_Base_Particle &base_particle);
 
@@ -61,6 +98,10 @@ public:
    HOST_DEVICE_CUDA
    bool putParticle(MC_Particle particle, int index);
 
+   // Copy a base particle into the vault at an existing index
+   HOST_DEVICE_CUDA
+   void putBaseParticle(const MC_Base_Particle &base_particle, int index);
+
    // invalidates the particle in the vault at an index
    HOST_DEVICE_CUDA
    void invalidateParticle( int index );
@@ -78,18 +119,221 @@ public:
 
 private:
 
+   // Copy the particle at index into/out of the storage.
+   HOST_DEVICE_CUDA
+   void loadBaseParticle(MC_Base_Particle &particle, size_t index) const;
+   HOST_DEVICE_CUDA
+   void storeBaseParticle(const MC_Base_Particle &particle, size_t index);
+
+   // Atomically claim count slots at the end of the vault, returns the first one.
+   HOST_DEVICE_CUDA
+   int claimIndex(int count);
+
+   // Drop the last particle.
+   void popBack();
+
+#ifndef SOA_VAULT
    // The container of particles.
    qs_vector<MC_Base_Particle> _particles;
+#else
+   // One container per particle field.
+   int                                   _size;
+   qs_vector<MC_Vector>                  _coordinate;
+   qs_vector<MC_Vector>                  _velocity;
+   qs_vector<double>                     _kineticEnergy;
+   qs_vector<double>                     _weight;
+   qs_vector<double>                     _timeToCensus;
+   qs_vector<double>                     _age;
+   qs_vector<double>                     _numMeanFreePaths;
+   qs_vector<double>                     _numSegments;
+   qs_vector<uint64_t>                   _randomNumberSeed;
+   qs_vector<uint64_t>                   _identifier;
+   qs_vector<MC_Tally_Event::Enum>       _lastEvent;
+   qs_vector<int>                        _numCollisions;
+   qs_vector<int>                        _breed;
+   qs_vector<int>                        _species;
+   qs_vector<int>                        _domain;
+   qs_vector<int>                        _cell;
+#endif
 };
 
+#ifndef SOA_VAULT
+
+// -----------------------------------------------------------------------
+inline void ParticleVault::
+reserve(size_t n)
+{ 
+    _particles.reserve(n,VAR_MEM); 
+}
+
+// -----------------------------------------------------------------------
+inline void ParticleVault::
+append(ParticleVault & vault2)
+{
+    _particles.appendList( vault2._particles.size(), &vault2._particles[0] );
+}
+
+// -----------------------------------------------------------------------
+HOST_DEVICE_CUDA
+inline void ParticleVault::
+loadBaseParticle(MC_Base_Particle &particle, size_t index) const
+{
+    particle = _particles[index];
+}
+
+// -----------------------------------------------------------------------
+HOST_DEVICE_CUDA
+inline void ParticleVault::
+storeBaseParticle(const MC_Base_Particle &particle, size_t index)
+{
+    _particles[index] = particle;
+}
+
+// -----------------------------------------------------------------------
+HOST_DEVICE_CUDA
+inline int ParticleVault::
+claimIndex(int count)
+{
+    return _particles.atomic_Index_Inc(count);
+}
+
+// -----------------------------------------------------------------------
+inline void ParticleVault::
+popBack()
+{
+    _particles.pop_back();
+}
+
+HOST_DEVICE_CUDA inline double&   ParticleVault::weight(size_t n)           { return _particles[n].weight; }
+HOST_DEVICE_CUDA inline double&   ParticleVault::kineticEnergy(size_t n)    { return _particles[n].kinetic_energy; }
+HOST_DEVICE_CUDA inline uint64_t& ParticleVault::randomNumberSeed(size_t n) { return _particles[n].random_number_seed; }
+HOST_DEVICE_CUDA inline uint64_t& ParticleVault::identifier(size_t n)       { return _particles[n].identifier; }
+HOST_DEVICE_CUDA inline int&      ParticleVault::species(size_t n)          { return _particles[n].species; }
+HOST_DEVICE_CUDA inline int&      ParticleVault::domain(size_t n)           { return _particles[n].domain; }
+HOST_DEVICE_CUDA inline int&      ParticleVault::cell(size_t n)             { return _particles[n].cell; }
+
+#else // SOA_VAULT
+
+// -----------------------------------------------------------------------
+inline void ParticleVault::
+reserve(size_t n)
+{ 
+    _coordinate.resize(n, VAR_MEM);
+    _velocity.resize(n, VAR_MEM);
+    _kineticEnergy.resize(n, VAR_MEM);
+    _weight.resize(n, VAR_MEM);
+    _timeToCensus.resize(n, VAR_MEM);
+    _age.resize(n, VAR_MEM);
+    _numMeanFreePaths.resize(n, VAR_MEM);
+    _numSegments.resize(n, VAR_MEM);
+    _randomNumberSeed.resize(n, VAR_MEM);
+    _identifier.resize(n, VAR_MEM);
+    _lastEvent.resize(n, VAR_MEM);
+    _numCollisions.resize(n, VAR_MEM);
+    _breed.resize(n, VAR_MEM);
+    _species.resize(n, VAR_MEM);
+    _domain.resize(n, VAR_MEM);
+    _cell.resize(n, VAR_MEM);
+}
+
+// -----------------------------------------------------------------------
+inline void ParticleVault::
+append(ParticleVault & vault2)
+{
+    int size = _size;
+    int listSize = vault2._size;
+    qs_assert( size + listSize < _weight.capacity() );
+
+    _size += listSize;
+    for ( int ii = 0; ii < listSize; ii++ )
+    {
+        MC_Base_Particle particle;
+        vault2.loadBaseParticle(particle, ii);
+        storeBaseParticle(particle, size + ii);
+    }
+}
+
+// -----------------------------------------------------------------------
+HOST_DEVICE_CUDA
+inline void ParticleVault::
+loadBaseParticle(MC_Base_Particle &particle, size_t index) const
+{
+    particle.coordinate          = _coordinate[index];
+    particle.velocity            = _velocity[index];
+    particle.kinetic_energy      = _kineticEnergy[index];
+    particle.weight              = _weight[index];
+    particle.time_to_census      = _timeToCensus[index];
+    particle.age                 = _age[index];
+    particle.num_mean_free_paths = _numMeanFreePaths[index];
+    particle.num_segments        = _numSegments[index];
+    particle.random_number_seed  = _randomNumberSeed[index];
+    particle.identifier          = _identifier[index];
+    particle.last_event          = _lastEvent[index];
+    particle.num_collisions      = _numCollisions[index];
+    particle.breed               = _breed[index];
+    particle.species             = _species[index];
+    particle.domain              = _domain[index];
+    particle.cell                = _cell[index];
+}
+
+// -----------------------------------------------------------------------
+HOST_DEVICE_CUDA
+inline void ParticleVault::
+storeBaseParticle(const MC_Base_Particle &particle, size_t index)
+{
+    _coordinate[index]       = particle.coordinate;
+    _velocity[index]         = particle.velocity;
+    _kineticEnergy[index]    = particle.kinetic_energy;
+    _weight[index]           = particle.weight;
+    _timeToCensus[index]     = particle.time_to_census;
+    _age[index]              = particle.age;
+    _numMeanFreePaths[index] = particle.num_mean_free_paths;
+    _numSegments[index]      = particle.num_segments;
+    _randomNumberSeed[index] = particle.random_number_seed;
+    _identifier[index]       = particle.identifier;
+    _lastEvent[index]        = particle.last_event;
+    _numCollisions[index]    = particle.num_collisions;
+    _breed[index]            = particle.breed;
+    _species[index]          = particle.species;
+    _domain[index]           = particle.domain;
+    _cell[index]             = particle.cell;
+}
+
+// -----------------------------------------------------------------------
+HOST_DEVICE_CUDA
+inline int ParticleVault::
+claimIndex(int count)
+{
+    int pos;
+    QS::atomicCaptureAdd( _size, count, pos );
+    return pos;
+}
+
+// -----------------------------------------------------------------------
+inline void ParticleVault::
+popBack()
+{
+    _size--;
+}
+
+HOST_DEVICE_CUDA inline double&   ParticleVault::weight(size_t n)           { return _weight[n]; }
+HOST_DEVICE_CUDA inline double&   ParticleVault::kineticEnergy(size_t n)    { return _kineticEnergy[n]; }
+HOST_DEVICE_CUDA inline uint64_t& ParticleVault::randomNumberSeed(size_t n) { return _randomNumberSeed[n]; }
+HOST_DEVICE_CUDA inline uint64_t& ParticleVault::identifier(size_t n)       { return _identifier[n]; }
+HOST_DEVICE_CUDA inline int&      ParticleVault::species(size_t n)          { return _species[n]; }
+HOST_DEVICE_CUDA inline int&      ParticleVault::domain(size_t n)           { return _domain[n]; }
+HOST_DEVICE_CUDA inline int&      ParticleVault::cell(size_t n)             { return _cell[n]; }
+
+#endif // SOA_VAULT
+
 // -----------------------------------------------------------------------
 HOST_DEVICE_CUDA
 inline void ParticleVault::
 pushParticle(MC_Particle &particle)
 {
     MC_Base_Particle base_particle(particle);
-    size_t indx = _particles.atomic_Index_Inc(1);
-    _particles[indx] = base_particle;
+    size_t indx = claimIndex(1);
+    storeBaseParticle(base_particle, indx);
 }
 
 // -----------------------------------------------------------------------
@@ -97,8 +341,18 @@ HOST_DEVICE_CUDA
 inline void ParticleVault::
 pushBaseParticle(MC_Base_Particle &base_particle)
 {
-    int indx = _particles.atomic_Index_Inc(1);
-    _particles[indx] = base_particle;
+    int indx = claimIndex(1);
+    storeBaseParticle(base_particle, indx);
+}
+
+// -----------------------------------------------------------------------
+HOST_DEVICE_CUDA
+inline void ParticleVault::
+pushBaseParticles(const MC_Base_Particle *list, int count)
+{
+    int indx = claimIndex(count);
+    for ( int ii = 0; ii < count; ii++ )
+        storeBaseParticle(list[ii], indx + ii);
 }
 
 // -----------------------------------------------------------------------
@@ -111,8 +365,8 @@ popBaseParticle(MC_Base_Particle &base_particle)
 {
    if (!empty())
    {
-      base_particle = _particles.back();
-      _particles.pop_back();
+      loadBaseParticle(base_particle, size()-1);
+      popBack();
       notEmpty = true;
    }
 }
@@ -129,8 +383,9 @@ popParticle(MC_Particle &particle)
 {
    if (!empty())
    {
-      MC_Base_Particle base_particle(_particles.back());
-      _particles.pop_back();
+      MC_Base_Particle base_particle;
+      loadBaseParticle(base_particle, size()-1);
+      popBack();
       particle = MC_Particle(base_particle);
       notEmpty = true;
    }
@@ -142,10 +397,10 @@ popParticle(MC_Particle &particle)
 inline bool ParticleVault::
 getBaseParticleComm( MC_Base_Particle &particle, int index )
 {
-    if( size() > index )
+    if( (int) size() > index )
     {
-            particle = _particles[index];
-            _particles[index].species = -1;
+            loadBaseParticle(particle, index);
+            species(index) = -1;
             return true;
     }
     else
@@ -160,10 +415,11 @@ getBaseParticleComm( MC_Base_Particle &particle, int index )
 inline bool ParticleVault::
 getParticle( MC_Particle &particle, int index )
 {
-    qs_assert( size() > index );
-    if( size() > index )
+    qs_assert( (int) size() > index );
+    if( (int) size() > index )
     {
-            MC_Base_Particle base_particle( _particles[index] );
+            MC_Base_Particle base_particle;
+            loadBaseParticle(base_particle, index);
             particle = MC_Particle( base_particle );
             return true;
     }
@@ -175,24 +431,33 @@ getParticle( MC_Particle &particle, int index )
 inline bool ParticleVault::
 putParticle(MC_Particle particle, int index)
 {
-    qs_assert( size() > index );
-    if( size() > index )
+    qs_assert( (int) size() > index );
+    if( (int) size() > index )
     {
         MC_Base_Particle base_particle( particle );
-        _particles[index] = base_particle;
+        storeBaseParticle(base_particle, index);
         return true;
     }
     return false;
 }
 
+// -----------------------------------------------------------------------
+   HOST_DEVICE_CUDA
+inline void ParticleVault::
+putBaseParticle(const MC_Base_Particle &base_particle, int index)
+{
+    qs_assert( (int) size() > index );
+    storeBaseParticle(base_particle, index);
+}
+
 // -----------------------------------------------------------------------
    HOST_DEVICE_CUDA
 inline void ParticleVault::
 invalidateParticle( int index )
 {
     qs_assert( index >= 0 );
-    qs_assert( index < _particles.size() );
-    _particles[index].species = -1;
+    qs_assert( index < (int) size() );
+    species(index) = -1;
 }
 
 // -----------------------------------------------------------------------
@@ -201,8 +466,10 @@ eraseSwapParticle(int index)
 {
     #include "mc_omp_critical.hh"
     {
-        _particles[index] = _particles.back();
-        _particles.pop_back();
+        MC_Base_Particle base_particle;
+        loadBaseParticle(base_particle, size()-1);
+        storeBaseParticle(base_particle, index);
+        popBack();
     }
 }
 
@@ -1,8 +1,32 @@
 #include "ParticleVaultContainer.hh"
 #include "ParticleVault.hh"
+#include "MC_Base_Particle.hh"
 #include "SendQueue.hh"
 #include "MemoryControl.hh"
 #include "qs_assert.hh"
+#include "macros.hh"
+
+#ifdef PARTICLE_STAGING
+//--------------------------------------------------------------
+// Per thread staging buffers.  Padded so that two threads never
+// write to the same cache line.
+//--------------------------------------------------------------
+struct ParticleStage
+{
+    static const int capacity = 32;
+
+    MC_Base_Particle extra[capacity];
+    int numExtra;
+
+    MC_Base_Particle census[capacity];
+    int numCensus;
+    ParticleVault *censusVault;
+
+    char pad[64];
+
+    ParticleStage() : numExtra(0), numCensus(0), censusVault(NULL) {}
+};
+#endif
 
 //--------------------------------------------------------------
 //------------ParticleVaultContainer Constructor----------------
@@ -49,6 +73,11 @@ ParticleVaultContainer( uint64_t vault_size,
 
     _sendQueue = MemoryControl::allocate<SendQueue>(1 ,VAR_MEM);
     _sendQueue->reserve( vault_size );
+
+#ifdef PARTICLE_STAGING
+    _numStages = omp_get_max_threads();
+    _stage = new ParticleStage[_numStages];
+#endif
 }
 
 //--------------------------------------------------------------
@@ -72,6 +101,10 @@ ParticleVaultContainer::
         MemoryControl::deallocate(_extraVault[ii], 1, VAR_MEM);
     }
     MemoryControl::deallocate( _sendQueue, 1, VAR_MEM );
+
+#ifdef PARTICLE_STAGING
+    delete [] _stage;
+#endif
 }
 
 //--------------------------------------------------------------
@@ -341,13 +374,97 @@ HOST_DEVICE
 void ParticleVaultContainer::
 addExtraParticle( MC_Particle &particle)
 {
+#ifdef PARTICLE_STAGING
+    ParticleStage &stage = _stage[omp_get_thread_num()];
+    if( stage.numExtra == ParticleStage::capacity )
+        flushExtraStage( stage );
+    stage.extra[stage.numExtra++] = MC_Base_Particle( particle );
+#else
     uint64_t index = 0;
     QS::atomicCaptureAdd( this->_extraVaultIndex, UINT64_C(1), index ); 
     uint64_t vault = index / this->_vaultSize;
     _extraVault[vault]->pushParticle( particle );
+#endif
 }
 HOST_DEVICE_END
 
+//--------------------------------------------------------------
+//------------addCensusParticle---------------------------------
+//adds a particle to a processed vault (used in kernel)
+//--------------------------------------------------------------
+HOST_DEVICE
+void ParticleVaultContainer::
+addCensusParticle( MC_Particle &particle, ParticleVault *processedVault )
+{
+#ifdef PARTICLE_STAGING
+    ParticleStage &stage = _stage[omp_get_thread_num()];
+    if( stage.numCensus == ParticleStage::capacity || 
+        ( stage.numCensus > 0 && stage.censusVault != processedVault ) )
+        flushCensusStage( stage );
+    stage.censusVault = processedVault;
+    stage.census[stage.numCensus++] = MC_Base_Particle( particle );
+#else
+    processedVault->pushParticle( particle );
+#endif
+}
+HOST_DEVICE_END
+
+#ifdef PARTICLE_STAGING
+//--------------------------------------------------------------
+//------------flushExtraStage-----------------------------------
+//Claims space for all staged extra particles with one atomic
+//and copies them into the extra vaults.
+//--------------------------------------------------------------
+void ParticleVaultContainer::
+flushExtraStage( ParticleStage &stage )
+{
+    uint64_t count = stage.numExtra;
+    uint64_t index = 0;
+    QS::atomicCaptureAdd( this->_extraVaultIndex, count, index );
+
+    // The claimed range may straddle two extra vaults
+    uint64_t done = 0;
+    while( done < count )
+    {
+        uint64_t vault = (index + done) / this->_vaultSize;
+        uint64_t room  = this->_vaultSize - (index + done) % this->_vaultSize;
+        uint64_t n     = ( count - done < room ) ? count - done : room;
+        _extraVault[vault]->pushBaseParticles( &stage.extra[done], n );
+        done += n;
+    }
+    stage.numExtra = 0;
+}
+
+//--------------------------------------------------------------
+//------------flushCensusStage----------------------------------
+//Copies all staged census particles into their processed vault
+//--------------------------------------------------------------
+void ParticleVaultContainer::
+flushCensusStage( ParticleStage &stage )
+{
+    stage.censusVault->pushBaseParticles( stage.census, stage.numCensus );
+    stage.numCensus = 0;
+}
+#endif
+
+//--------------------------------------------------------------
+//------------flushStagedParticles------------------------------
+//Empties every thread's staging buffers into the vaults
+//--------------------------------------------------------------
+void ParticleVaultContainer::
+flushStagedParticles()
+{
+#ifdef PARTICLE_STAGING
+    for( int ii = 0; ii < _numStages; ii++ )
+    {
+        if( _stage[ii].numExtra > 0 )
+            flushExtraStage( _stage[ii] );
+        if( _stage[ii].numCensus > 0 )
+            flushCensusStage( _stage[ii] );
+    }
+#endif
+}
+
 //--------------------------------------------------------------
 //------------cleanExtraVaults----------------------------------
 //Moves the particles from the _extraVault into the 
@@ -4,9 +4,18 @@
 #include "DeclareMacro.hh"
 
 #include "portability.hh"
+#include "gpuPortability.hh"
 #include "QS_Vector.hh"
 #include <vector>
 
+// On the cpu each thread stages secondary and census particles in a
+// small private buffer and moves them into the vaults in bulk, so the
+// tracking loop does not take an atomic per particle.  Device builds
+// keep the per-particle atomics.
+#if !defined(GPU_NATIVE) && !defined(HAVE_OPENMP_TARGET)
+#define PARTICLE_STAGING
+#endif
+
 //---------------------------------------------------------------
 // ParticleVaultContainer is a container of ParticleVaults. 
 // These Vaults are broken down into user defined chunks that can 
@@ -22,6 +31,7 @@ class MC_Base_Particle;
 class MC_Particle;
 class ParticleVault;
 class SendQueue;
+struct ParticleStage;
 
 //typedef unsigned long long int uint64_cu;
 
@@ -77,6 +87,15 @@ class ParticleVaultContainer
     HOST_DEVICE
     void addExtraParticle( MC_Particle &particle );
     HOST_DEVICE_END
+
+    //Adds a censused particle to the given processed vault
+    HOST_DEVICE
+    void addCensusParticle( MC_Particle &particle, ParticleVault *processedVault );
+    HOST_DEVICE_END
+
+    //Moves all staged extra and census particles into their 
+    //vaults.  Must be called after each tracking kernel.
+    void flushStagedParticles();
  
     //Pushes particles from Extra Vaults onto the Processing 
     //Vault list
@@ -108,6 +127,15 @@ class ParticleVaultContainer
 
     //The list of extra particle vaults (size - fixed)
     qs_vector<ParticleVault*>   _extraVault;
+
+#ifdef PARTICLE_STAGING
+    //Per thread staging buffers for extra and census particles
+    int _numStages;
+    ParticleStage *_stage;
+
+    void flushExtraStage( ParticleStage &stage );
+    void flushCensusStage( ParticleStage &stage );
+#endif
      
 };
 
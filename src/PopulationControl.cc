@@ -82,8 +82,8 @@ void PopulationControlGuts(const double splitRRFactor, uint64_t currentNumPartic
 
         uint64_t taskParticleIndex = particleIndex%vault_size;
 
-        MC_Base_Particle &currentParticle = taskProcessingVault[taskParticleIndex];
-        double randomNumber = rngSample(&currentParticle.random_number_seed);
+        uint64_t &currentSeed = taskProcessingVault.randomNumberSeed(taskParticleIndex);
+        double randomNumber = rngSample(&currentSeed);
         if (splitRRFactor < 1)
         {
             if (randomNumber > splitRRFactor)
@@ -94,7 +94,7 @@ void PopulationControlGuts(const double splitRRFactor, uint64_t currentNumPartic
 	        }
 	        else
 	        {
-	            currentParticle.weight /= splitRRFactor;
+	            taskProcessingVault.weight(taskParticleIndex) /= splitRRFactor;
 	        }
         }
         else if (splitRRFactor > 1)
@@ -103,15 +103,15 @@ void PopulationControlGuts(const double splitRRFactor, uint64_t currentNumPartic
 	        int splitFactor = (int)floor(splitRRFactor);
 	        if (randomNumber > (splitRRFactor - splitFactor)) { splitFactor--; }
 	  
-	        currentParticle.weight /= splitRRFactor;
-	        MC_Base_Particle splitParticle = currentParticle;
+	        taskProcessingVault.weight(taskParticleIndex) /= splitRRFactor;
+	        MC_Base_Particle splitParticle = taskProcessingVault[taskParticleIndex];
 	  
 	        for (int splitFactorIndex = 0; splitFactorIndex < splitFactor; splitFactorIndex++)
 	        {
 	            taskBalance._split++;
 	     
 	            splitParticle.random_number_seed = rngSpawn_Random_Number_Seed(
-			        &currentParticle.random_number_seed);
+			        &currentSeed);
 	            splitParticle.identifier = splitParticle.random_number_seed;
 
                 my_particle_vault->addProcessingParticle( splitParticle, fill_vault_index );
@@ -148,15 +148,15 @@ void RouletteLowWeightParticles(MonteCarlo* monteCarlo)
 
             ParticleVault& taskProcessingVault = *(monteCarlo->_particleVaultContainer->getTaskProcessingVault(vault_index));
             uint64_t taskParticleIndex = particleIndex%vault_size;
-	        MC_Base_Particle &currentParticle = taskProcessingVault[taskParticleIndex];
+	        double &currentWeight = taskProcessingVault.weight(taskParticleIndex);
 
-	        if (currentParticle.weight <= weightCutoff)
+	        if (currentWeight <= weightCutoff)
 	        {
-	            double randomNumber = rngSample(&currentParticle.random_number_seed);
+	            double randomNumber = rngSample(&taskProcessingVault.randomNumberSeed(taskParticleIndex));
 	            if (randomNumber <= lowWeightCutoff)
 	            {
 		            // The particle history continues with an increased weight.
-		            currentParticle.weight /= lowWeightCutoff;
+		            currentWeight /= lowWeightCutoff;
 	            }
 	            else
 	            {
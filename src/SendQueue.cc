@@ -6,7 +6,21 @@ SendQueue::SendQueue()
 
 SendQueue::SendQueue( size_t size )
 : _data( size, VAR_MEM )
-{}
+{
+    for( int i = 0; i < _data.capacity(); i++ )
+        _data[i]._particleIndex = -1;
+}
+
+// -----------------------------------------------------------------------
+void SendQueue::
+reserve( size_t size )
+{
+    _data.reserve(size, VAR_MEM);
+
+    // An unpublished tuple has _particleIndex == -1
+    for( int i = 0; i < _data.capacity(); i++ )
+        _data[i]._particleIndex = -1;
+}
 
 
 // -----------------------------------------------------------------------
@@ -37,14 +51,36 @@ push( int neighbor_, int vault_index_ )
     size_t indx = _data.atomic_Index_Inc(1);
 
     _data[indx]._neighbor    = neighbor_;
-    _data[indx]._particleIndex = vault_index_;
+
+    // Make the particle and the neighbor visible before publishing the tuple
+#if defined HAVE_OPENMP && ! defined HAVE_OPENMP_TARGET
+    #pragma omp flush
+#endif
+    QS::atomicWrite( _data[indx]._particleIndex, vault_index_ );
 }
 HOST_DEVICE_END
 
+// -----------------------------------------------------------------------
+bool SendQueue::
+published( int index_ )
+{
+    int particleIndex;
+#ifdef HAVE_OPENMP
+    #pragma omp atomic read
+#endif
+    particleIndex = _data[index_]._particleIndex;
+#ifdef HAVE_OPENMP
+    #pragma omp flush
+#endif
+    return particleIndex >= 0;
+}
+
 // -----------------------------------------------------------------------
 void SendQueue::
 clear()
 {
+    for( int i = 0; i < _data.size(); i++ )
+        _data[i]._particleIndex = -1;
     _data.clear();
 }
 
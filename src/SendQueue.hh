@@ -21,7 +21,7 @@ class SendQueue
     //Get the total size of the send Queue
     size_t size();
 
-    void reserve( size_t size ){ _data.reserve(size, VAR_MEM); }
+    void reserve( size_t size );
 
     //get the number of items in send queue going to a specific neighbor
     size_t neighbor_size( int neighbor_ );
@@ -32,6 +32,13 @@ class SendQueue
     HOST_DEVICE_CUDA
     void push( int neighbor_, int vault_index_ );
 
+    //True once the tuple at index_ has been completely written by push.
+    //Lets the MPI progress thread read the queue while it is being filled.
+    bool published( int index_ );
+
+    //Capacity of the send queue
+    size_t capacity(){ return _data.capacity(); }
+
     //Clear send queue before after use
     void clear();
 
@@ -7,10 +7,12 @@
 #include "MC_Fast_Timer.hh"
 
 #include <vector>
+#include <algorithm>
 using std::vector;
 
 void Tallies::CycleInitialize(MonteCarlo* monteCarlo)
 {
+    _spectrum.CycleInitialize();
 }
 
 void Tallies::SumTasks(void)
@@ -60,6 +62,8 @@ void Tallies::CycleFinalize(MonteCarlo *monteCarlo)
     _balanceTask[0]._split = sum[index++];
     _balanceTask[0]._numSegments = sum[index++];
 
+    ReduceScalarFlux();
+
     PrintSummary(monteCarlo);
 
     _balanceCumulative.Add(_balanceTask[0]);
@@ -74,32 +78,73 @@ void Tallies::CycleFinalize(MonteCarlo *monteCarlo)
 
     for (int domainIndex = 0; domainIndex < _scalarFluxDomain.size(); domainIndex++)
     {
-        //Sum Cell Tally Replications
-        for (int replication_index = 1; replication_index < _num_flux_replications; replication_index++)
+        // The cell tallies are not reported, so finalizing them only
+        // clears every replication.
+        CellTallyDomain& cellTallyDomain = _cellTallyDomain[domainIndex];
+        int numCells = cellTallyDomain._task[0]._cell.size();
+        #include "mc_omp_parallel_for_schedule_static.hh"
+        for (int cellIndex = 0; cellIndex < numCells; cellIndex++)
         {
-            _cellTallyDomain[domainIndex]._task[0].Add( _cellTallyDomain[domainIndex]._task[replication_index]);
-            _cellTallyDomain[domainIndex]._task[replication_index].Reset();  
+            for (int replication_index = 0; replication_index < _num_cellTally_replications; replication_index++)
+                cellTallyDomain._task[replication_index]._cell[cellIndex] = 0.0;
         }
 
-        //Sum Scalar Flux Tally Replications
-        for (int replication_index = 1; replication_index < _num_flux_replications; replication_index++)
+        if( monteCarlo->_params.simulationParams.coralBenchmark )
+            _fluence.compute( domainIndex, _cellScalarFlux[domainIndex] );
+    }
+    _spectrum.UpdateSpectrum(monteCarlo);
+}
+
+// Sums the scalar flux replications of every cell over the groups into
+// _cellScalarFlux and clears the replications in the same pass.  Cells
+// are spread over the threads and each cell's groups, which are
+// contiguous in the BulkStorage of a replication, are reduced a block at
+// a time in a vectorizable loop.  The sums are formed in TallySum and in
+// a fixed order, so they do not depend on the number of threads.
+void Tallies::ReduceScalarFlux()
+{
+    const int groupBlock = 64;
+
+    for (int domainIndex = 0; domainIndex < _scalarFluxDomain.size(); domainIndex++)
+    {
+        ScalarFluxDomain& scalarFluxDomain = _scalarFluxDomain[domainIndex];
+        vector<double>& cellScalarFlux = _cellScalarFlux[domainIndex];
+        int numCells = scalarFluxDomain._task[0]._cell.size();
+
+        #include "mc_omp_parallel_for_schedule_static.hh"
+        for (int cellIndex = 0; cellIndex < numCells; cellIndex++)
         {
-            _scalarFluxDomain[domainIndex]._task[0].Add(_scalarFluxDomain[domainIndex]._task[replication_index]);
-            _scalarFluxDomain[domainIndex]._task[replication_index].Reset();  
-        }
+            int numGroups = scalarFluxDomain._task[0]._cell[cellIndex].size();
+            double cellSum = 0.0;
+            for (int firstGroup = 0; firstGroup < numGroups; firstGroup += groupBlock)
+            {
+                int blockSize = std::min(groupBlock, numGroups - firstGroup);
+                TallySum groupSum[groupBlock];
+                for (int groupIndex = 0; groupIndex < blockSize; groupIndex++)
+                    groupSum[groupIndex] = 0.0;
 
-        if( monteCarlo->_params.simulationParams.coralBenchmark )
-            _fluence.compute( domainIndex, _scalarFluxDomain[domainIndex] );
+                for (int replication_index = 0; replication_index < _num_flux_replications; replication_index++)
+                {
+                    FluxReal* group = scalarFluxDomain._task[replication_index]._cell[cellIndex]._group + firstGroup;
+                    #pragma omp simd
+                    for (int groupIndex = 0; groupIndex < blockSize; groupIndex++)
+                    {
+                        groupSum[groupIndex] += group[groupIndex];
+                        group[groupIndex] = 0.0;
+                    }
+                }
 
-        _cellTallyDomain[domainIndex]._task[0].Reset();
-        _scalarFluxDomain[domainIndex]._task[0].Reset();
+                for (int groupIndex = 0; groupIndex < blockSize; groupIndex++)
+                    cellSum += groupSum[groupIndex];
+            }
+            cellScalarFlux[cellIndex] = cellSum;
+        }
     }
-    _spectrum.UpdateSpectrum(monteCarlo);
 }
 
-void Fluence::compute( int domainIndex, ScalarFluxDomain &scalarFluxDomain )
+void Fluence::compute( int domainIndex, const vector<double> &cellScalarFlux )
 {
-    int numCells = scalarFluxDomain._task[0]._cell.size();
+    int numCells = cellScalarFlux.size();
 
     while( this->_domain.size() <= domainIndex )
     {
@@ -109,15 +154,9 @@ void Fluence::compute( int domainIndex, ScalarFluxDomain &scalarFluxDomain )
 
     FluenceDomain* fluenceDomain = this->_domain[domainIndex];
 
+    #include "mc_omp_parallel_for_schedule_static.hh"
     for( int cellIndex = 0; cellIndex < numCells; cellIndex++ )
-    {
-        int numGroups = scalarFluxDomain._task[0]._cell[cellIndex].size();
-        for( int groupIndex = 0; groupIndex < numGroups; groupIndex++ )
-        {
-            fluenceDomain->addCell( cellIndex, scalarFluxDomain._task[0]._cell[cellIndex]._group[groupIndex]);
-        }
-    }
-
+        fluenceDomain->addCell( cellIndex, cellScalarFlux[cellIndex] );
 }
 
 void Tallies::PrintSummary(MonteCarlo *monteCarlo)
@@ -143,25 +182,16 @@ void Tallies::PrintSummary(MonteCarlo *monteCarlo)
    MC_FASTTIMER_START(MC_Fast_Timer::cycleFinalize); // restart the finalize timer
 }
 
+// The scalar flux of the cycle, summed by ReduceScalarFlux.
 double Tallies::ScalarFluxSum(MonteCarlo *monteCarlo)
 {
     double local_sum = 0.0;
 
-    for (int domainIndex = 0; domainIndex < _scalarFluxDomain.size(); domainIndex++)
+    for (size_t domainIndex = 0; domainIndex < _cellScalarFlux.size(); domainIndex++)
     {
-        for (int replication_index = 0; replication_index < _num_flux_replications; replication_index++)
-        {
-            int numCells = _scalarFluxDomain[domainIndex]._task[replication_index]._cell.size();
-
-            for (int cellIndex = 0; cellIndex < numCells; cellIndex++)
-            {
-                int numGroups = _scalarFluxDomain[domainIndex]._task[replication_index]._cell[cellIndex].size();
-                for (int groupIndex = 0; groupIndex < numGroups; groupIndex++)
-                {
-                    local_sum += _scalarFluxDomain[domainIndex]._task[replication_index]._cell[cellIndex]._group[groupIndex];
-                }
-            }
-        }
+        const vector<double>& cellScalarFlux = _cellScalarFlux[domainIndex];
+        for (size_t cellIndex = 0; cellIndex < cellScalarFlux.size(); cellIndex++)
+            local_sum += cellScalarFlux[cellIndex];
     }
 
     double sum = 0.0;
@@ -173,9 +203,19 @@ double Tallies::ScalarFluxSum(MonteCarlo *monteCarlo)
 void Tallies::InitializeTallies( MonteCarlo *monteCarlo, 
                         int balance_replications = 1, 
                         int flux_replications = 1, 
-                        int cell_replications = 1
+                        int cell_replications = 1,
+                        bool thread_replications = false
                         ) 
 {
+    // Each thread owns one replication of every tally.  The replications
+    // are filled in below, after the domains are in place.
+    #ifdef THREAD_TALLIES
+    if( thread_replications )
+    {
+        balance_replications = flux_replications = cell_replications = omp_get_max_threads();
+        _threadReplications = true;
+    }
+    #endif
 
     //Set num replications from input parameters
     _num_balance_replications   = balance_replications;
@@ -197,7 +237,7 @@ void Tallies::InitializeTallies( MonteCarlo *monteCarlo,
         for( int reps = 0; reps < _num_balance_replications; reps++ )
         {
             //Push back a Constructed object onto the qs vector
-            _balanceTask.push_back( Balance() ); 
+            _balanceTask.push_back( BalanceReplication() ); 
         }
         //Close the qs vectors diss-allowing push back
         _balanceTask.Close();
@@ -214,7 +254,10 @@ void Tallies::InitializeTallies( MonteCarlo *monteCarlo,
         for (int domainIndex = 0; domainIndex < monteCarlo->domain.size(); domainIndex++)
         {   
             _cellTallyDomain.push_back(CellTallyDomain(&monteCarlo->domain[domainIndex],
-                                                       _num_cellTally_replications));
+                                                       _threadReplications ? 0 : _num_cellTally_replications));
+            if( _threadReplications )
+                _cellTallyDomain.back().InitializeThreadReplications(&monteCarlo->domain[domainIndex],
+                                                                     _num_cellTally_replications);
         }   
         _cellTallyDomain.Close();
     }
@@ -231,8 +274,16 @@ void Tallies::InitializeTallies( MonteCarlo *monteCarlo,
         {
             _scalarFluxDomain.push_back(ScalarFluxDomain(&monteCarlo->domain[domainIndex],
                                                           monteCarlo->_nuclearData->_energies.size()-1,
-                                                         _num_flux_replications));
+                                                         _threadReplications ? 0 : _num_flux_replications));
+            if( _threadReplications )
+                _scalarFluxDomain.back().InitializeThreadReplications(&monteCarlo->domain[domainIndex],
+                                                                      monteCarlo->_nuclearData->_energies.size()-1,
+                                                                      _num_flux_replications);
         }
         _scalarFluxDomain.Close();
+
+        _cellScalarFlux.resize(monteCarlo->domain.size());
+        for (int domainIndex = 0; domainIndex < monteCarlo->domain.size(); domainIndex++)
+            _cellScalarFlux[domainIndex].assign(monteCarlo->domain[domainIndex].cell_state.size(), 0.0);
     }
 }
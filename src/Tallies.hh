@@ -12,11 +12,19 @@
 #include "utils.hh"
 #include "macros.hh"
 #include "BulkStorage.hh"
+#include "FixedPointTally.hh"
 #include "DeclareMacro.hh"
 #include "EnergySpectrum.hh"
 
 //typedef unsigned long long int uint64_cu;
 
+// On the cpu each thread can own one replication of every tally
+// (threadTallies) and add to it without atomics.  Device builds always
+// map particles to replications by index.
+#if !defined(GPU_NATIVE) && !defined(HAVE_OPENMP_TARGET)
+#define THREAD_TALLIES
+#endif
+
 class Fluence;
 
 struct MC_Tally_Event
@@ -51,10 +59,12 @@ class Balance
    uint64_t _split;       // Number of particles split in population control
    uint64_t _numSegments; // Number of segements
 
+   HOST_DEVICE_CUDA
    Balance() :
       _absorb(0), _census(0), _escape(0), _collision(0), _end(0), _fission(0), _produce(0), _scatter(0), _start(0),
       _source(0), _rr(0), _split(0), _numSegments(0) { }
 
+   HOST_DEVICE_CUDA
    ~Balance() {}
 
     void PrintHeader()
@@ -81,7 +91,8 @@ class Balance
           _rr = _split = _numSegments = 0;
    }
 
-   void Add(Balance &bal)
+   HOST_DEVICE_CUDA
+   void Add(const Balance &bal)
    {
       _absorb      += bal._absorb;
       _census      += bal._census;
@@ -97,17 +108,47 @@ class Balance
       _split       += bal._split;
       _numSegments += bal._numSegments;
    }
+
+   // Add the counters of one history to a shared replication.  Most of
+   // them are zero, so only the others cost an atomic.
+   HOST_DEVICE_CUDA
+   void AtomicAdd(const Balance &bal)
+   {
+      if (bal._absorb)      QS::atomicAdd(_absorb,      bal._absorb);
+      if (bal._census)      QS::atomicAdd(_census,      bal._census);
+      if (bal._escape)      QS::atomicAdd(_escape,      bal._escape);
+      if (bal._collision)   QS::atomicAdd(_collision,   bal._collision);
+      if (bal._end)         QS::atomicAdd(_end,         bal._end);
+      if (bal._fission)     QS::atomicAdd(_fission,     bal._fission);
+      if (bal._produce)     QS::atomicAdd(_produce,     bal._produce);
+      if (bal._scatter)     QS::atomicAdd(_scatter,     bal._scatter);
+      if (bal._start)       QS::atomicAdd(_start,       bal._start);
+      if (bal._source)      QS::atomicAdd(_source,      bal._source);
+      if (bal._rr)          QS::atomicAdd(_rr,          bal._rr);
+      if (bal._split)       QS::atomicAdd(_split,       bal._split);
+      if (bal._numSegments) QS::atomicAdd(_numSegments, bal._numSegments);
+   }
+};
+
+// One replication of the balance tally.  The padding keeps the counters
+// of neighbouring replications at least a cache line apart, whatever the
+// alignment of the array that holds them, so threads that each own a
+// replication do not share lines.
+class BalanceReplication : public Balance
+{
+   public:
+   char _pad[64];
 };
 
 class ScalarFluxCell
 {
    public:
-   double* _group;
+   FluxReal* _group;
    int _size;
 
    ScalarFluxCell() : _group(0), _size(0) {}
 
-   ScalarFluxCell(double* storage, int size)
+   ScalarFluxCell(FluxReal* storage, int size)
    :  _group(storage),
       _size(size)
    {
@@ -126,7 +167,7 @@ class ScalarFluxCell
 class CellTallyTask
 {
   public:
-    qs_vector<double> _cell;
+    qs_vector<CellTallyReal> _cell;
 
     CellTallyTask() : _cell() {}
 
@@ -168,7 +209,7 @@ class ScalarFluxTask
 {
    public:
    qs_vector<ScalarFluxCell> _cell;
-   BulkStorage<double> _scalarFluxCellStorage;
+   BulkStorage<FluxReal> _scalarFluxCellStorage;
 
    ScalarFluxTask() : _cell() {}
 
@@ -183,7 +224,7 @@ class ScalarFluxTask
        _cell.Open();
       for (int cellIndex = 0; cellIndex < domain->cell_state.size(); cellIndex++)
       {
-         double* tmp = _scalarFluxCellStorage.getBlock(numGroups);
+         FluxReal* tmp = _scalarFluxCellStorage.getBlock(numGroups);
          _cell.push_back(ScalarFluxCell(tmp, numGroups));
       }
       _cell.Close();
@@ -238,6 +279,20 @@ class CellTallyDomain
       _task.Close();
    }
 
+   // Give each thread its own replication.  Thread task_index builds,
+   // and so first touches, replication task_index, which places it in
+   // memory local to that thread.  The domain must be constructed with
+   // zero replications.
+   void InitializeThreadReplications(MC_Domain* domain, int numThreads)
+   {
+      _task.resize(numThreads, VAR_MEM);
+      #pragma omp parallel for schedule (static)
+      for (int task_index = 0; task_index < numThreads; task_index++)
+      {
+          _task[task_index] = CellTallyTask(domain);
+      }
+   }
+
    ~CellTallyDomain() {}
 };
 
@@ -263,6 +318,17 @@ class ScalarFluxDomain
       _task.Close();
    }
 
+   // As CellTallyDomain::InitializeThreadReplications.
+   void InitializeThreadReplications(MC_Domain* domain, int numGroups, int numThreads)
+   {
+      _task.resize(numThreads, VAR_MEM);
+      #pragma omp parallel for schedule (static)
+      for (int task_index = 0; task_index < numThreads; task_index++)
+      {
+          _task[task_index] = ScalarFluxTask(domain, numGroups);
+      }
+   }
+
    ~ScalarFluxDomain() {}
 };
 
@@ -293,25 +359,54 @@ class Fluence
         }
     }
 
-    void compute(int domain, ScalarFluxDomain &scalarFluxDomain);
+    void compute(int domain, const std::vector<double> &cellScalarFlux);
 
     std::vector<FluenceDomain*> _domain;
 };
 
+class Tallies;
+
+// Holds the scalar flux contribution of a history until it moves to a
+// different (cell, group), so consecutive segments in the same cell and
+// group cost one tally update instead of one each.
+class ScalarFluxAccumulator
+{
+   public:
+
+   HOST_DEVICE_CUDA
+   ScalarFluxAccumulator(Tallies* tallies, int task)
+   : _tallies(tallies), _task(task), _domain(-1), _cell(-1), _group(-1), _value(0.0) {}
+
+   HOST_DEVICE_CUDA
+   inline void Tally(double value, int domain, int cell, int group);
+
+   HOST_DEVICE_CUDA
+   inline void Flush();
+
+   private:
+   Tallies* _tallies;
+   int _task;
+   int _domain;
+   int _cell;
+   int _group;
+   double _value;
+};
+
 class Tallies
 {
   public:
-    Balance                     _balanceCumulative;
-    qs_vector<Balance>          _balanceTask;
-    qs_vector<ScalarFluxDomain> _scalarFluxDomain;
-    qs_vector<CellTallyDomain>  _cellTallyDomain;
-    Fluence                     _fluence;
-    EnergySpectrum              _spectrum;
+    Balance                       _balanceCumulative;
+    qs_vector<BalanceReplication> _balanceTask;
+    qs_vector<ScalarFluxDomain>   _scalarFluxDomain;
+    qs_vector<CellTallyDomain>    _cellTallyDomain;
+    Fluence                       _fluence;
+    EnergySpectrum                _spectrum;
     
     Tallies( int balRep, int fluxRep, int cellRep, std::string spectrumName, int spectrumSize )
       : _balanceCumulative(), _balanceTask(),
         _scalarFluxDomain(), _num_balance_replications(balRep), 
         _num_flux_replications(fluxRep), _num_cellTally_replications(cellRep), 
+        _threadReplications(false),
         _spectrum(spectrumName, spectrumSize)
     {
     }
@@ -334,12 +429,42 @@ class Tallies
         return _num_cellTally_replications;
     }
 
+    // The replication a particle tallies into: the one owned by the
+    // calling thread with threadTallies, otherwise one picked by index.
+    HOST_DEVICE_CUDA
+    int GetBalanceReplication(int particle_index)
+    {
+        #ifdef THREAD_TALLIES
+        if (_threadReplications) return omp_get_thread_num();
+        #endif
+        return particle_index % _num_balance_replications;
+    }
+
+    HOST_DEVICE_CUDA
+    int GetFluxReplication(int particle_index)
+    {
+        #ifdef THREAD_TALLIES
+        if (_threadReplications) return omp_get_thread_num();
+        #endif
+        return particle_index % _num_flux_replications;
+    }
+
+    HOST_DEVICE_CUDA
+    int GetCellTallyReplication(int particle_index)
+    {
+        #ifdef THREAD_TALLIES
+        if (_threadReplications) return omp_get_thread_num();
+        #endif
+        return particle_index % _num_cellTally_replications;
+    }
+
     ~Tallies() {}
 
     void InitializeTallies( MonteCarlo *monteCarlo, 
                             int balance_replications, 
                             int flux_replications, 
-                            int cell_replications);
+                            int cell_replications,
+                            bool thread_replications);
 
     void CycleInitialize(MonteCarlo* monteCarlo);
 
@@ -347,25 +472,67 @@ class Tallies
     void CycleFinalize(MonteCarlo *mcco);
     void PrintSummary(MonteCarlo *mcco);
 
+    HOST_DEVICE_CUDA
+    void TallyBalance(const Balance &balance, int task)
+    {
+        if (_threadReplications)
+            _balanceTask[task].Add(balance);
+        else
+            _balanceTask[task].AtomicAdd(balance);
+    }
+
     HOST_DEVICE_CUDA
     void TallyScalarFlux(double value, int domain, int task, int cell, int group)
     {
-        QS::atomicAdd( _scalarFluxDomain[domain]._task[task]._cell[cell]._group[group], value );
+        if (_threadReplications)
+            _scalarFluxDomain[domain]._task[task]._cell[cell]._group[group] += value;
+        else
+            QS::atomicAdd( _scalarFluxDomain[domain]._task[task]._cell[cell]._group[group], (FluxReal) value );
     }
 
     HOST_DEVICE_CUDA
     void TallyCellValue(double value, int domain, int task, int cell)
     {
-        QS::atomicAdd( _cellTallyDomain[domain]._task[task]._cell[cell], value );
+        if (_threadReplications)
+            _cellTallyDomain[domain]._task[task]._cell[cell] += value;
+        else
+            QS::atomicAdd( _cellTallyDomain[domain]._task[task]._cell[cell], (CellTallyReal) value );
     }
 
     double ScalarFluxSum(MonteCarlo *mcco);
 
   private:
+    void ReduceScalarFlux();
+
+    std::vector<std::vector<double> > _cellScalarFlux;   // per domain, the scalar flux of each cell this cycle
+
     int _num_balance_replications;
     int _num_flux_replications;
     int _num_cellTally_replications;
+    bool _threadReplications;        // each thread owns one replication of every tally
 
 };
 
+HOST_DEVICE_CUDA
+inline void ScalarFluxAccumulator::Tally(double value, int domain, int cell, int group)
+{
+   if (cell != _cell || group != _group || domain != _domain)
+   {
+      Flush();
+      _domain = domain;
+      _cell = cell;
+      _group = group;
+   }
+   _value += value;
+}
+
+HOST_DEVICE_CUDA
+inline void ScalarFluxAccumulator::Flush()
+{
+   if (_cell >= 0)
+      _tallies->TallyScalarFlux(_value, _domain, _task, _cell, _group);
+   _cell = -1;
+   _value = 0.0;
+}
+
 #endif
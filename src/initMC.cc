@@ -23,6 +23,7 @@
 #include "gpuPortability.hh"
 #include "cudaUtils.hh"
 #include "cudaFunctions.hh"
+#include "CycleTracking.hh"
 
 using std::vector;
 using std::string;
@@ -36,6 +37,7 @@ namespace
 {
    void initGPUInfo(MonteCarlo* monteCarlo);
    void initNuclearData(MonteCarlo* monteCarlo, const Parameters& params);
+   void initCrossSectionTables(Material& material, NuclearData* nuclearData);
    void initMesh(MonteCarlo* monteCarlo, const Parameters& params);
    void initTallies(MonteCarlo* monteCarlo, const Parameters& params);
    void initTimeInfo(MonteCarlo* monteCarlo, const Parameters& params);
@@ -47,6 +49,7 @@ namespace
                               vector<MC_Vector>& centers);
    void consistencyCheck(int myRank, const qs_vector<MC_Domain>& domain);
    void checkCrossSections(MonteCarlo* monteCarlo, const Parameters& params);
+   void initTrackingFeatures(MonteCarlo* monteCarlo, const Parameters& params);
 
 }
 
@@ -65,6 +68,7 @@ MonteCarlo* initMC(const Parameters& params)
    initNuclearData(monteCarlo, params);
    initMesh(monteCarlo, params);
    initTallies(monteCarlo, params);
+   initTrackingFeatures(monteCarlo, params);
 
    MC_Base_Particle::Update_Counts();
 
@@ -144,6 +148,10 @@ namespace
                                                     params.simulationParams.eMax);
          monteCarlo->_materialDatabase = new MaterialDatabase();
      #endif
+     monteCarlo->_nuclearData->_checkEnergyGroup = params.simulationParams.checkEnergyGroups;
+     monteCarlo->_nuclearData->_computeCrossSections = params.simulationParams.computeCrossSections;
+     monteCarlo->_nuclearData->_multigroupTransfer = params.simulationParams.multigroupTransfer;
+     monteCarlo->_nuclearData->_continuousEnergy = params.simulationParams.continuousEnergy;
 
      map<string, Polynomial> crossSection;
      for (auto crossSectionIter = params.crossSectionParams.begin();
@@ -165,6 +173,7 @@ namespace
      }
      
      monteCarlo->_nuclearData->_isotopes.reserve( num_isotopes, VAR_MEM );
+     monteCarlo->_nuclearData->_isotopeData.reserve( num_isotopes, VAR_MEM );
      monteCarlo->_materialDatabase->_mat.reserve( num_materials, VAR_MEM );
      
      for (auto matIter = params.materialParams.begin();
@@ -194,6 +203,75 @@ namespace
         }
         monteCarlo->_materialDatabase->addMaterial(material);
      }
+
+     monteCarlo->_nuclearData->buildCrossSectionTable();
+     if (monteCarlo->_nuclearData->_multigroupTransfer)
+        monteCarlo->_nuclearData->buildFissionTransfer();
+     if (monteCarlo->_nuclearData->_continuousEnergy)
+        monteCarlo->_nuclearData->buildPointwiseTables(params.simulationParams.nPoints);
+     for (int matIndex = 0; matIndex < monteCarlo->_materialDatabase->_mat.size(); matIndex++)
+        initCrossSectionTables(monteCarlo->_materialDatabase->_mat[matIndex], monteCarlo->_nuclearData);
+   }
+}
+
+namespace
+{
+   // Build the per group total cross sections that
+   // weightedMacroscopicCrossSection returns and the cumulative
+   // reaction cross sections that CollisionEvent searches.  The terms
+   // are the ones macroscopicCrossSection returns for a cell number
+   // density of 1, summed in the order the cell loops used.  The
+   // tables only depend on the nuclear data, so they are built once
+   // here rather than cached per cell.
+   void initCrossSectionTables(Material& material, NuclearData* nuclearData)
+   {
+      int numIsos = material._iso.size();
+      int numEntries = 0;
+      for (int isoIndex = 0; isoIndex < numIsos; isoIndex++)
+         numEntries += nuclearData->getNumberReactions(material._iso[isoIndex]._gid);
+
+      material._totalCrossSection.resize(nuclearData->_numEnergyGroups, VAR_MEM);
+      material._reactionIso.resize(numEntries, VAR_MEM);
+      material._reactionIndex.resize(numEntries, VAR_MEM);
+      material._reactionCdf.resize(numEntries * nuclearData->_numEnergyGroups, VAR_MEM);
+
+      for (int group = 0; group < nuclearData->_numEnergyGroups; group++)
+      {
+         double total = 0.0;
+         for (int isoIndex = 0; isoIndex < numIsos; isoIndex++)
+         {
+            double atomFraction = material._iso[isoIndex]._atomFraction;
+            if (atomFraction == 0.0)
+               total += 1e-20;
+            else
+               total += atomFraction * nuclearData->getTotalCrossSection(material._iso[isoIndex]._gid, group);
+         }
+         material._totalCrossSection[group] = total;
+
+         CrossSectionReal* cdf = &material._reactionCdf[group * numEntries];
+         double sum = 0.0;
+         int entry = 0;
+         for (int isoIndex = 0; isoIndex < numIsos; isoIndex++)
+         {
+            int isotopeGid = material._iso[isoIndex]._gid;
+            double atomFraction = material._iso[isoIndex]._atomFraction;
+            int numReacts = nuclearData->getNumberReactions(isotopeGid);
+            for (int reactIndex = 0; reactIndex < numReacts; reactIndex++)
+            {
+               if (atomFraction == 0.0)
+                  sum += 1e-20;
+               else
+                  sum += atomFraction * nuclearData->getReactionCrossSection(reactIndex, isotopeGid, group);
+               cdf[entry] = sum;
+               material._reactionIso[entry] = isoIndex;
+               material._reactionIndex[entry] = reactIndex;
+               entry++;
+            }
+         }
+      }
+
+      if (nuclearData->_multigroupTransfer)
+         nuclearData->buildScatterTransfer(material._mass, material._scatterTransfer);
    }
 }
 
@@ -308,8 +386,7 @@ namespace
       {
          if (myRank == 0) { cout << "Building MC_Domain " << ii << endl; }
          monteCarlo->domain.push_back(
-            MC_Domain(partition[ii], globalGrid, ddc, params, *monteCarlo->_materialDatabase,
-                      params.simulationParams.nGroups));
+            MC_Domain(partition[ii], globalGrid, ddc, params, *monteCarlo->_materialDatabase));
       }
       monteCarlo->domain.Close();
       
@@ -328,7 +405,8 @@ namespace
          monteCarlo,  
          params.simulationParams.balanceTallyReplications,
          params.simulationParams.fluxTallyReplications,
-         params.simulationParams.cellTallyReplications
+         params.simulationParams.cellTallyReplications,
+         params.simulationParams.threadTallies != 0
       );
    }
 }
@@ -425,12 +503,12 @@ namespace
          for (unsigned iIso=0; iIso<nIsotopes; ++iIso)
          {
             int isotopeGid = monteCarlo->_materialDatabase->_mat[iMat]._iso[iIso]._gid;
-            unsigned nReactions = nd->_isotopes[isotopeGid]._species[0]._reactions.size();
+            unsigned nReactions = nd->getNumberReactions(isotopeGid);
             // for each reaction
             for (unsigned iReact=0; iReact<nReactions; ++iReact)
             {
                // loop over energies
-               NuclearDataReaction& reaction = nd->_isotopes[isotopeGid]._species[0]._reactions[iReact];
+               NuclearDataReaction& reaction = nd->getReaction(iReact, isotopeGid);
                // accumulate cross sections by reaction type
                for (unsigned iGroup=0; iGroup<nGroups; ++iGroup)
                {
@@ -483,3 +561,53 @@ namespace
     fclose( xSec );
    }
 }
+
+namespace
+{
+   // Find the problem features that select a specialized tracking
+   // kernel.  Each test must be exact: a specialized kernel drops the
+   // branches for the excluded events entirely.
+   void initTrackingFeatures(MonteCarlo* monteCarlo, const Parameters& params)
+   {
+      int features = TrackingFeature::General;
+
+      // A fission reaction with a zero scale has a zero cross section in
+      // every cross section mode and is never selected.
+      bool noFission = true;
+      NuclearData* nuclearData = monteCarlo->_nuclearData;
+      for (int isoIndex = 0; isoIndex < nuclearData->_isotopes.size(); isoIndex++)
+      {
+         const qs_vector<NuclearDataReaction>& reactions = nuclearData->_isotopes[isoIndex]._species[0]._reactions;
+         for (int reactIndex = 0; reactIndex < reactions.size(); reactIndex++)
+            if (reactions[reactIndex]._reactionType == NuclearDataReaction::Fission &&
+                reactions[reactIndex]._scale != 0.0)
+               noFission = false;
+      }
+      if (noFission)
+         features |= TrackingFeature::NoFission;
+
+      if (params.simulationParams.boundaryCondition == "reflect")
+         features |= TrackingFeature::AllReflective;
+
+      bool singleMaterial = true;
+      int material = -1;
+      for (int domainIndex = 0; domainIndex < monteCarlo->domain.size(); domainIndex++)
+      {
+         const qs_vector<MC_Cell_State>& cellState = monteCarlo->domain[domainIndex].cell_state;
+         for (int cellIndex = 0; cellIndex < cellState.size(); cellIndex++)
+         {
+            if (material == -1)
+               material = cellState[cellIndex]._material;
+            else if (cellState[cellIndex]._material != material)
+               singleMaterial = false;
+         }
+      }
+      if (singleMaterial && material != -1)
+      {
+         features |= TrackingFeature::SingleMaterial;
+         monteCarlo->_trackingMaterial = material;
+      }
+
+      monteCarlo->_trackingFeatures = features;
+   }
+}
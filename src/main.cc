@@ -1,4 +1,5 @@
 #include <iostream>
+#include <algorithm>
 #include "utils.hh"
 #include "Parameters.hh"
 #include "utilsMpi.hh"
@@ -22,6 +23,9 @@
 #include "CycleTracking.hh"
 #include "CoralBenchmark.hh"
 #include "EnergySpectrum.hh"
+#include "ParticleScheduler.hh"
+#include "ParticleSort.hh"
+#include "QS_atomics.hh"
 
 #include "git_hash.hh"
 #include "git_vers.hh"
@@ -29,6 +33,7 @@
 void gameOver();
 void cycleInit( bool loadBalance );
 void cycleTracking(MonteCarlo* monteCarlo);
+void cycleTrackingWithProgressThread(MonteCarlo *monteCarlo, ParticleVault *processingVault, ParticleVault *processedVault);
 void cycleFinalize();
 
 using namespace std;
@@ -90,6 +95,8 @@ void gameOver()
                                         mcco->processor_info-> num_processors,
                                         mcco->processor_info->comm_mc_world,
                                         mcco->_tallies->_balanceCumulative._numSegments);
+    if ( mcco->particle_scheduler != NULL )
+        mcco->particle_scheduler->printIdleTime(mcco);
     mcco->_tallies->_spectrum.PrintSpectrum(mcco);
 }
 
@@ -98,8 +105,6 @@ void cycleInit( bool loadBalance )
 
     MC_FASTTIMER_START(MC_Fast_Timer::cycleInit);
 
-    mcco->clearCrossSectionCache();
-
     mcco->_tallies->CycleInitialize(mcco);
 
     mcco->_particleVaultContainer->swapProcessingProcessedVaults();
@@ -117,6 +122,8 @@ void cycleInit( bool loadBalance )
 
     RouletteLowWeightParticles(mcco); // Delete particles with low statistical weight
 
+    SortProcessingParticles(mcco); // Group particles by cell (and energy group) for locality
+
     MC_FASTTIMER_STOP(MC_Fast_Timer::cycleInit);
 }
 
@@ -135,6 +142,76 @@ GLOBAL void CycleTrackingKernel( MonteCarlo* monteCarlo, int num_particles, Part
 
 #endif
 
+#if defined HAVE_OPENMP
+
+//----------------------------------------------------------------------------------------------------------------------
+// Track one vault on threads 1..n-1 while thread 0 keeps the particle exchange moving: it packs and sends particles
+// from the send queue as they are queued, and receives particles from other ranks.  Received particles are held
+// back until tracking is done, since the processing vaults are in use.
+//----------------------------------------------------------------------------------------------------------------------
+void cycleTrackingWithProgressThread(MonteCarlo *monteCarlo, ParticleVault *processingVault, ParticleVault *processedVault)
+{
+    const int chunkSize = 16;
+    int numParticles = processingVault->size();
+    int nextParticle = 0;
+    int activeThreads = 0;
+
+    SendQueue &sendQueue = *(monteCarlo->_particleVaultContainer->getSendQueue());
+    MC_Particle_Buffer *particle_buffer = monteCarlo->particle_buffer;
+
+    particle_buffer->Allocate_Send_Buffers(true);
+
+    #pragma omp parallel
+    {
+        int thread = omp_get_thread_num();
+        int numThreads = omp_get_num_threads();
+
+        if ( thread == 0 ) { activeThreads = numThreads - 1; }
+        #pragma omp barrier
+
+        // Tracking threads (thread 0 tracks too if it is alone)
+        if ( thread != 0 || numThreads == 1 )
+        {
+            int begin;
+            QS::atomicCaptureAdd( nextParticle, chunkSize, begin );
+            while ( begin < numParticles )
+            {
+                int end = std::min( begin + chunkSize, numParticles );
+                for ( int particle_index = begin; particle_index < end; particle_index++ )
+                {
+                    CycleTrackingGuts( monteCarlo, particle_index, processingVault, processedVault );
+                }
+                QS::atomicCaptureAdd( nextParticle, chunkSize, begin );
+            }
+
+            #pragma omp flush
+            if ( thread != 0 ) { QS::atomicAdd( activeThreads, -1 ); }
+        }
+
+        // Progress thread
+        if ( thread == 0 )
+        {
+            int packed = 0;
+            bool trackingDone = false;
+            do
+            {
+                int remaining;
+                #pragma omp atomic read
+                remaining = activeThreads;
+                #pragma omp flush
+                trackingDone = ( remaining == 0 );
+
+                packed = particle_buffer->Progress_Send_Queue( sendQueue, processingVault, packed, trackingDone );
+                particle_buffer->Receive_Particle_Buffers_Deferred();
+            } while ( !trackingDone );
+
+            qs_assert( packed == (int) sendQueue.size() );
+        }
+    }
+}
+
+#endif
+
 void cycleTracking(MonteCarlo *monteCarlo)
 {
     MC_FASTTIMER_START(MC_Fast_Timer::cycleTracking);
@@ -144,6 +221,14 @@ void cycleTracking(MonteCarlo *monteCarlo)
     //Determine whether or not to use GPUs if they are available (set for each MPI rank)
     ExecutionPolicy execPolicy = getExecutionPolicy( monteCarlo->processor_info->use_gpu );
 
+    //A dedicated MPI progress thread only helps with several ranks and several threads
+    bool useProgressThread = false;
+    #if defined HAVE_OPENMP
+    useProgressThread = monteCarlo->_params.simulationParams.mpiProgressThread &&
+                        monteCarlo->processor_info->num_processors > 1 &&
+                        omp_get_max_threads() > 1;
+    #endif
+
     ParticleVaultContainer &my_particle_vault = *(monteCarlo->_particleVaultContainer);
 
     //Post Inital Receives for Particle Buffer
@@ -169,6 +254,8 @@ void cycleTracking(MonteCarlo *monteCarlo)
                 ParticleVault *processedVault =  my_particle_vault.getTaskProcessedVault(processed_vault);
             
                 int numParticles = processingVault->size();
+
+                bool trackedWithProgressThread = false;
             
                 if ( numParticles != 0 )
                 {
@@ -179,6 +266,7 @@ void cycleTracking(MonteCarlo *monteCarlo)
                     // * As an OpenMP 4.5 parallel loop on the GPU
                     // * As an OpenMP 3.0 parallel loop on the CPU
                     // * AS a single thread on the CPU.
+                    // * As an event-based loop over event queues on the CPU.
                     switch (execPolicy)
                     {
                       case gpuNative:
@@ -225,6 +313,24 @@ void cycleTracking(MonteCarlo *monteCarlo)
                        break;
 
                       case cpu:
+                       if ( monteCarlo->_params.simulationParams.eventTracking )
+                       {
+                          CycleTrackingEventBased( monteCarlo, processingVault, processedVault );
+                          break;
+                       }
+                       #if defined HAVE_OPENMP
+                       if ( useProgressThread )
+                       {
+                          cycleTrackingWithProgressThread( monteCarlo, processingVault, processedVault );
+                          trackedWithProgressThread = true;
+                          break;
+                       }
+                       #endif
+                       if ( monteCarlo->particle_scheduler != NULL )
+                       {
+                          monteCarlo->particle_scheduler->trackVault( monteCarlo, processingVault, processedVault );
+                          break;
+                       }
                        #include "mc_omp_parallel_for_schedule_static.hh"
                        for ( int particle_index = 0; particle_index < numParticles; particle_index++ )
                        {
@@ -234,6 +340,9 @@ void cycleTracking(MonteCarlo *monteCarlo)
                       default:
                        qs_assert(false);
                     } // end switch
+
+                    // Move staged secondary and census particles into the vaults
+                    my_particle_vault.flushStagedParticles();
                 }
 
                 particle_count += numParticles;
@@ -247,21 +356,26 @@ void cycleTracking(MonteCarlo *monteCarlo)
                 NVTX_Range cleanAndComm("cycleTracking_clean_and_comm");
                 
                 SendQueue &sendQueue = *(my_particle_vault.getSendQueue());
-                monteCarlo->particle_buffer->Allocate_Send_Buffer( sendQueue );
 
-                //Move particles from send queue to the send buffers
-                for ( int index = 0; index < sendQueue.size(); index++ )
+                // The progress thread has already sent everything in the send queue
+                if ( !trackedWithProgressThread )
                 {
-                    sendQueueTuple& sendQueueT = sendQueue.getTuple( index );
-                    MC_Base_Particle mcb_particle;
+                    monteCarlo->particle_buffer->Allocate_Send_Buffer( sendQueue );
 
-                    processingVault->getBaseParticleComm( mcb_particle, sendQueueT._particleIndex );
+                    //Move particles from send queue to the send buffers
+                    for ( int index = 0; index < sendQueue.size(); index++ )
+                    {
+                        sendQueueTuple& sendQueueT = sendQueue.getTuple( index );
+                        MC_Base_Particle mcb_particle;
 
-                    int buffer = monteCarlo->particle_buffer->Choose_Buffer(sendQueueT._neighbor );
-                    monteCarlo->particle_buffer->Buffer_Particle(mcb_particle, buffer );
-                }
+                        processingVault->getBaseParticleComm( mcb_particle, sendQueueT._particleIndex );
+
+                        int buffer = monteCarlo->particle_buffer->Choose_Buffer(sendQueueT._neighbor );
+                        monteCarlo->particle_buffer->Buffer_Particle(mcb_particle, buffer );
+                    }
 
-                monteCarlo->particle_buffer->Send_Particle_Buffers(); // post MPI sends
+                    monteCarlo->particle_buffer->Send_Particle_Buffers(); // post MPI sends
+                }
 
                 processingVault->clear(); //remove the invalid particles
                 sendQueue.clear();
@@ -269,6 +383,9 @@ void cycleTracking(MonteCarlo *monteCarlo)
                 // Move particles in "extra" vaults into the regular vaults.
                 my_particle_vault.cleanExtraVaults();
 
+                // Add the particles the progress thread received during tracking
+                monteCarlo->particle_buffer->Add_Deferred_Particles( fill_vault );
+
                 // receive any particles that have arrived from other ranks
                 monteCarlo->particle_buffer->Receive_Particle_Buffers( fill_vault );
 
@@ -7,4 +7,31 @@
 #include <cstdint>
 #endif
 
+// Storage types of the cross section tables and the tallies.
+// With MIXED_PRECISION the cross sections and the scalar flux are stored
+// in single precision, which halves their footprint.  Arithmetic on the
+// stored values stays in double.  With FIXED_POINT_TALLIES the scalar
+// flux and cell tallies are stored in fixed point (FixedPointTally.hh),
+// and TallySum, the type replications are summed in, is fixed point too.
+#ifdef MIXED_PRECISION
+typedef float CrossSectionReal;
+#else
+typedef double CrossSectionReal;
+#endif
+
+#if defined FIXED_POINT_TALLIES
+class FixedPointTally;
+typedef FixedPointTally FluxReal;
+typedef FixedPointTally CellTallyReal;
+typedef FixedPointTally TallySum;
+#elif defined MIXED_PRECISION
+typedef float FluxReal;
+typedef double CellTallyReal;
+typedef double TallySum;
+#else
+typedef double FluxReal;
+typedef double CellTallyReal;
+typedef double TallySum;
+#endif
+
 #endif